@@ -10,272 +10,21 @@
  */
 #pragma once
 
-#include <cstdint>
-#include <cstddef>
-#include <climits>
-#include <limits>
-#include <type_traits>
-#include <tuple>
-
-#ifndef   bitpacker_CPLUSPLUS
-# if defined(_MSVC_LANG ) && !defined(__clang__)
-#  define bitpacker_CPLUSPLUS  (_MSC_VER == 1900 ? 201103L : _MSVC_LANG )
-# else
-#  define bitpacker_CPLUSPLUS  __cplusplus
-# endif
-#endif
-
-#define bitpacker_CPP98_OR_GREATER  ( bitpacker_CPLUSPLUS >= 199711L )
-#define bitpacker_CPP11_OR_GREATER  ( bitpacker_CPLUSPLUS >= 201103L )
-#define bitpacker_CPP14_OR_GREATER  ( bitpacker_CPLUSPLUS >= 201402L )
-#define bitpacker_CPP17_OR_GREATER  ( bitpacker_CPLUSPLUS >= 201703L )
-#define bitpacker_CPP20_OR_GREATER  ( bitpacker_CPLUSPLUS > 201703L )
+#include "core.hpp"
 
-#if bitpacker_CPP20_OR_GREATER && defined(__has_include )
+#include <array>
+#include <tuple>
+#include <iterator>
+#if bitpacker_CPP20_OR_GREATER
 #include <algorithm>
-# if __has_include( <span> )
-#  define bitpacker_HAVE_STD_SPAN  1
-# else
-#  define bitpacker_HAVE_STD_SPAN  0
-# endif
-#else
-# define  bitpacker_HAVE_STD_SPAN  0
 #endif
 
-#if bitpacker_HAVE_STD_SPAN
-#    include <span>
-#else
-#    if defined __has_include
-#        if __has_include(<gsl/gsl-lite.hpp>)
-#            include <gsl/gsl-lite.hpp>
-namespace bitpacker {
-using gsl::span;
-}
-#        elif __has_include(<nonstd/span.hpp>)
-#            include <nonstd/span.hpp>
-namespace bitpacker {
-using nonstd::span;
-}
-#        elif __has_include(<gsl/gsl>)
-#            include <gsl/gsl>
-namespace bitpacker {
-using gsl::span;
-}
-#        endif
-#    endif
-#endif
+#if bitpacker_CPP17_OR_GREATER
+#include <string_view>
+#include <optional>
+#include <variant>
 
 namespace bitpacker {
-#if bitpacker_HAVE_STD_SPAN
-    using std::span;
-    using std::as_bytes;
-#endif
-
-# if bitpacker_CPP17_OR_GREATER && defined(BITPACKER_USE_STD_BYTE)
-    using byte_type = std::byte;
-#else
-    using byte_type = uint8_t;
-# endif
-
-    using size_type = std::size_t;
-    constexpr size_type ByteSize = sizeof(byte_type) * CHAR_BIT;
-    static_assert(CHAR_BIT == 8, "The target system has bytes that are not 8 bits!");
-    static_assert(static_cast<unsigned>(-1) == ~0U, "The target system is not 2's compliment! Default pack specializations will not work!");
-    static_assert(
-#if bitpacker_CPP17_OR_GREATER && defined(BITPACKER_USE_STD_BYTE)
-            std::is_same<byte_type, std::byte>::value ||
-#endif
-            std::is_unsigned<byte_type>::value && std::is_integral<byte_type>::value && sizeof(byte_type) == 1U,
-            "ByteType needs to be either std::byte or uint8_t");
-
-    namespace impl {
-
-        /// Represents a given bit offset
-        struct Offset {
-            size_type byte;
-            size_type bit;
-        };
-
-        /// returns true if the bit offset is byte aligned
-        constexpr bool is_aligned(const size_type bit_offset) noexcept {
-            return (bit_offset % ByteSize) == 0;
-        }
-
-        /// returns true if the offset is byte aligned
-        constexpr bool is_aligned(const Offset offset) noexcept {
-            return offset.bit == 0;
-        }
-
-        /// get the byte and bit offset of a given bit number
-        constexpr Offset get_offset(size_type offset) noexcept {
-            return { (offset / ByteSize), (offset % ByteSize) };
-        }
-        /// create mask from the nth bit from the MSB to bit 0 (inclusive)
-        constexpr byte_type right_mask(const size_type n) noexcept {
-            return static_cast< byte_type >((1U << (ByteSize - n)) - 1);
-        }
-        /// create mask from the nth bit from the MSB to bit 8 (inclusive)
-        constexpr byte_type left_mask(const size_type n) noexcept {
-            return static_cast<byte_type>(~static_cast<byte_type>(right_mask(n) >> 1U));
-        }
-
-        /// finds the smallest fixed width unsigned integer that can fit NumBits bits
-        template <size_type NumBits>
-        using unsigned_type = std::conditional_t<NumBits <= 8, uint8_t,
-                std::conditional_t<NumBits <= 16, uint16_t,
-                        std::conditional_t<NumBits <= 32, uint32_t,
-                                std::conditional_t<NumBits <= 64, uint64_t,
-                                        void >>>>;
-
-        /// finds the smallest fixed width signed integer that can fit NumBits bits
-        template <size_type NumBits>
-        using signed_type = std::conditional_t<NumBits <= 8, int8_t,
-                std::conditional_t<NumBits <= 16, int16_t,
-                        std::conditional_t<NumBits <= 32, int32_t,
-                                std::conditional_t<NumBits <= 64, int64_t,
-                                        void >>>>;
-#pragma warning(push)
-#pragma warning(disable : 4293)
-        /// sign extends an unsigned integral value to prepare for casting to a signed value.
-        template<typename T, size_type BitSize>
-        constexpr signed_type<BitSize> sign_extend(T val) noexcept
-        {
-            using return_type = signed_type<BitSize>;
-            static_assert( std::is_unsigned<T>::value && std::is_integral<T>::value, "ValueType needs to be an unsigned integral type");
-            // warning disabled for shifts bigger than type, since this if statement avoids that case.
-            // if constexpr would work too, but trying to keep this section c++14 compatable
-            if (BitSize < (sizeof(T)*ByteSize)) {
-                const T upper_mask = static_cast<T>(~((static_cast<return_type>(1U) << BitSize) - 1));
-                const T msb = static_cast<return_type>(1U) << (BitSize - 1);
-                if (val & msb) { 
-                    return static_cast<return_type>(val | upper_mask);
-                }
-            }
-            return static_cast<return_type>(val);
-        }
-#pragma warning(pop)
-
-        /// reverses the bits in the value `val`.
-        template < typename T, size_type BitSize >
-        constexpr auto reverse_bits(std::remove_cv_t< T > val) noexcept
-        {
-            using val_type = std::remove_reference_t< decltype(val) >;
-            static_assert(std::is_integral<val_type>::value, "bitpacker::reverse_bits: val needs to be an integral type");
-            using return_type = std::remove_reference_t< std::remove_cv_t< T >>;
-            size_type count = BitSize-1;
-            return_type retval = val & 0x01U;
-
-            val >>= 1U;
-            while (val && count) {
-                retval <<= 1U;
-                retval |= val & 0x01U;
-                val >>= 1U;
-                --count;
-            }
-            return retval << count; 
-        }
-
-    }  // implementation namespace
-
-    /**
-     * Inserts an unsigned integral value `v` into the byte buffer `buffer`. The value will overwrite
-     * the bits from bit `offset` to `offset` + `size` counting from the most significant bit of the first byte
-     * in the buffer. Bits adjacent to this field will not be modified.
-     * @tparam ValueType Type of the value `v` to insert. Must be an unsigned integral type.
-     * @param buffer [IN/OUT] Span of bytes to insert the value `v` into
-     * @param offset [IN] the bit offset to insert at. The value `v` will begin at this bit index
-     * @param size [IN] the number of bits to use for inserting the value `v`. Must be <= 64.
-     * @param v [IN] the value to insert into the byte container
-     */
-    template<typename ValueType>
-    constexpr void insert(span<byte_type> buffer, size_type offset, size_type size, ValueType v) noexcept {
-        static_assert( std::is_unsigned<ValueType>::value && std::is_integral<ValueType>::value, "bitpacker::insert : ValueType needs to be an unsigned integral type");
-        const auto start = impl::get_offset(offset);
-        const auto end   = impl::get_offset(offset + size - 1);
-        const byte_type startMask   = impl::right_mask(start.bit);    // mask of the start byte, 1s where data is
-        const byte_type endMask     = impl::left_mask(end.bit);       // mask of the end byte, 1s where data is
-
-        // mask off any bits outside the size of the actual field, if size < bits in ValueType
-        // NOTE: it is UB to left shift ANY value if the shift is >= the bits in the value!
-        // this also takes care of zero size values.
-        if( size < sizeof(ValueType)*ByteSize ) {
-            v &= static_cast<ValueType>(( ValueType{0x1U} << size) - 1);
-        }
-
-        if (start.byte == end.byte) {
-            // case where start and end are in the same byte
-            buffer[start.byte] &= static_cast<byte_type>(~( static_cast<uint8_t>(startMask & endMask)));
-            buffer[start.byte] |= static_cast<byte_type>(v << (ByteSize - (end.bit + 1)));
-        }
-        else {
-            // case where start and end are in different bytes
-            buffer[end.byte] &= static_cast<byte_type>(~endMask);
-            // TODO: simpler way to get shift. byte aligned data is a special case (%ByteSize and the ternary)
-            buffer[end.byte] |= static_cast<byte_type>(v << (ByteSize - ((end.bit+1)%ByteSize) ) % ByteSize);
-            v >>= ((end.bit+1)%ByteSize) != 0 ? (end.bit+1)%ByteSize : ByteSize;
-
-            for (size_type i = end.byte - 1; i > start.byte; --i) {
-                buffer[i] = static_cast<byte_type>(v);
-                // NOLINTNEXTLINE - this loop will NOT run 1-byte types
-                v >>= ByteSize;
-            }
-
-            buffer[start.byte] &= static_cast<byte_type>(~startMask);
-            buffer[start.byte] |= static_cast<byte_type>(v);
-        }
-    }
-
-    /**
-     * Extracts an unsigned integral value from the byte buffer `buffer`. The value will be equal to
-     * the bits from bit `offset` to `offset` + `size` counting from the most significant bit of the first byte
-     * in the buffer.
-     * @tparam ReturnType The return type of this function. Must be an unsigned integral type
-     * @param buffer [IN] view of bytes to extract the value from. They will not be modified.
-     * @param offset [IN] the bit offset to extract from. The return value will begin at this bit index.
-     * @param size [IN] the number of bits to use, starting from `offset`, to construct the return value. Must be <= 64.
-     * @return The unsigned integral value contained in `buffer` bit [`offset`, `offset`+`size`-1]. If ReturnType is
-     *         not explicitly specified the smalled fixed width unsigned integer that can contain the value will be returned.
-     */
-    template<typename ReturnType>
-    constexpr ReturnType extract(span<const byte_type> buffer, size_type offset, size_type size) noexcept {
-        static_assert( std::is_unsigned<ReturnType>::value && std::is_integral<ReturnType>::value, "ReturnType needs to be an unsigned integral type");
-        const auto start = impl::get_offset(offset);
-        const auto end   = impl::get_offset(offset + size - 1);
-
-        // case where size is zero
-        if (size == 0) {
-            return 0;
-        }
-
-        // case where the the entire field is in one byte
-        if (start.byte == end.byte) {
-            const size_type shift = (ByteSize - (end.bit + 1));
-            // NOLINTNEXTLINE - size will always be <= 8 if we are within a byte!
-            const size_type mask  = (1u << size) - 1;
-            return static_cast<ReturnType>( static_cast<uint8_t>((buffer[start.byte]) >> shift) & mask );
-        }
-
-        // case where the field covers 2 or more bytes
-        ReturnType value = static_cast<uint8_t>(buffer[start.byte]) & static_cast<uint8_t>(impl::right_mask(start.bit));
-        for (size_type i = start.byte + 1; i < end.byte; ++i) {
-            value = static_cast<ReturnType>(static_cast<ReturnType>(value << ByteSize) | static_cast<uint8_t>(buffer[i]));
-        }
-        const ReturnType shifted_end   = static_cast<ReturnType>(static_cast<uint8_t>(buffer[end.byte]) >> (ByteSize - (end.bit+1)));
-        const ReturnType shifted_value = static_cast<ReturnType>(value << (end.bit + 1));
-        return shifted_value | shifted_end;
-    }
-
-    /************************  Template specialization for unpacking  ***************************/
-
-    template <typename T>
-    constexpr T get(span<const byte_type> buffer, size_type offset) noexcept;
-
-    /*************************  Template specialization for packing  ****************************/
-
-    template <typename T>
-    constexpr void store(span<byte_type> buffer, size_type offset, T value) noexcept;
-
-#if bitpacker_CPP17_OR_GREATER
     /***************************************************************************************************
      * TMP (compile time) pack and unpack functionality (C++17 required)
      ***************************************************************************************************/
@@ -344,30 +93,64 @@ namespace bitpacker {
 
         struct RawFormatType {
             char formatChar;    //< the format character of this items type
-            size_type count;       //< number of bits in this item
+            size_type count;       //< number of bits in this item (all elements for an array item)
             size_type offset;      //< offset from start of format in bits
             impl::Endian endian;//< bit endianness of this value
+            size_type repeat;      //< number of elements for an array item (`u12[4]`), 0 for a single value
+            bool counted;          //< true for an array item counted by an earlier field (`s14[#0]`), `count` is then the element size
+            size_type count_field; //< for a counted array item, index of the non-padding field holding the element count
+            size_type group;       //< 1 based index of the optional group (`{#k:...}`) holding this item, 0 if it is always present
+            size_type gate_field;  //< for an item in an optional group, index of the non-padding 'b' field that says if the group is present
         };
 
+        /// the number of bits in one element of the given item
+        constexpr size_type element_bits(const RawFormatType &t) noexcept
+        {
+            return t.repeat != 0 ? t.count / t.repeat : t.count;
+        }
+
         // Specifying the Big Endian format
-        template <char FormatChar, size_type BitCount, impl::Endian BitEndianess>
+        template <char FormatChar, size_type BitCount, impl::Endian BitEndianess, size_type Repeat = 0>
         struct FormatType {
             static constexpr impl::Endian bit_endian = BitEndianess;
-            static constexpr size_type bits = BitCount;        // also used for byte count for 't' and 'r' formats
+            static constexpr size_type bits = BitCount;        // bits of one element, also used for byte count for 't' and 'r' formats
+            static constexpr size_type repeat = Repeat;        // number of elements for an array item, 0 for a single value
             static constexpr char format = FormatChar;
-            using return_type = format_type<FormatChar, BitCount>;
+            using element = FormatType<FormatChar, BitCount, BitEndianess>;
+            using return_type = std::conditional_t< Repeat == 0, format_type<FormatChar, BitCount>,
+                                                    std::array< format_type<FormatChar, BitCount>, Repeat > >;
             using rep_type = impl::unsigned_type<BitCount>;
         };
 
         /// validates the given format string
         template <typename Fmt>
         constexpr bool validate_format(Fmt /*unused*/) noexcept {
+            bool in_group = false;
             for(size_type i = 0; i < Fmt::size(); i++) {
                 auto currentChar = Fmt::at(i);
                 if(impl::isFormatMode(currentChar)) {
                     if(++i == Fmt::size()){
                         break;
                     }
+                    currentChar = Fmt::at(i);
+                }
+
+                // `{#k:...}` is an optional group, present when non-padding field k is true. Groups don't nest.
+                if(currentChar == '{') {
+                    const auto gate_and_offset = impl::consume_number(Fmt::value(), i + 2);
+                    if(in_group || Fmt::at(i + 1) != '#' || gate_and_offset.second == i + 2 || Fmt::at(gate_and_offset.second) != ':') {
+                        return false;
+                    }
+                    in_group = true;
+                    i = gate_and_offset.second;
+                    continue;
+                }
+                if(currentChar == '}') {
+                    if(!in_group) {
+                        return false;
+                    }
+                    in_group = false;
+                    continue;
                 }
 
                 if(!impl::isFormatType(Fmt::at(i++))) {
@@ -376,12 +159,23 @@ namespace bitpacker {
 
                 const auto num_and_offset = impl::consume_number(Fmt::value(), i);
                 i = num_and_offset.second;
-                --i; // to combat the i++ in the loop
                 if(num_and_offset.first == 0) {
                     return false;
                 }
+                if(i < Fmt::size() && Fmt::at(i) == '[') {
+                    // `[N]` is a fixed length array, `[#k]` an array counted by non-padding field k
+                    const bool counted = (i + 1 < Fmt::size()) && Fmt::at(i + 1) == '#';
+                    const size_type first_digit = i + (counted ? 2 : 1);
+                    const auto repeat_and_offset = impl::consume_number(Fmt::value(), first_digit);
+                    i = repeat_and_offset.second;
+                    if(i == first_digit || (!counted && repeat_and_offset.first == 0) || i >= Fmt::size() || Fmt::at(i) != ']') {
+                        return false;
+                    }
+                    ++i;
+                }
+                --i; // to combat the i++ in the loop
             }
-            return true;
+            return !in_group;
         }
 
         /// return the format mode of the entire buffer (byte order).
@@ -402,7 +196,6 @@ namespace bitpacker {
         template <typename Fmt>
         constexpr size_type count_fmt_items(Fmt /*unused*/, const bool count_padding = true, const bool count_normal = true) noexcept
         {
-            static_assert(validate_format(Fmt{}), "Invalid Format!");
             size_type itemCount = 0;
             bool count_item = false;
 
@@ -429,35 +222,18 @@ namespace bitpacker {
             return itemCount;
         }
 
-        /// count the number of items in the format
-        template <typename Fmt>
-        constexpr size_type count_all_items(Fmt /*unused*/) noexcept
-        {
-            return count_fmt_items(Fmt{}, true, true);
-        }
-
-        /// count the number of non-padding items in the format
-        template <typename Fmt>
-        constexpr size_type count_non_padding(Fmt /*unused*/) noexcept
-        {
-            return count_fmt_items(Fmt{}, false, true);
-        }
-
-        /// count the number of padding type items in the format
-        template <typename Fmt>
-        constexpr size_type count_padding(Fmt /*unused*/) noexcept
-        {
-            return count_fmt_items(Fmt{}, true, false);
-        }
-
-        /// parse the given format string to a homogenous array of objects that describe each type
-        template < typename Fmt>
-        constexpr auto get_type_array(Fmt /*unused*/) noexcept
+        /// parse the given format string to a homogenous array of objects that describe each type.
+        /// Use `layout<Fmt>::types` (or `get_type_array()`) instead, which parses each format only once.
+        template < size_type ItemCount, typename Fmt >
+        constexpr auto parse_type_array(Fmt /*unused*/) noexcept
         {
-            std::array< RawFormatType, count_all_items(Fmt{}) > arr{};
+            std::array< RawFormatType, ItemCount > arr{};
             impl::Endian currentEndian = impl::Endian::big;
             size_type currentType = 0;
             size_type offset = 0;
+            size_type currentGroup = 0;
+            size_type currentGate = 0;
+            bool groupOpen = false;
 
             for (size_type i = 0; i < Fmt::size(); i++) {
                 auto currentChar = Fmt::at(i);
@@ -466,23 +242,211 @@ namespace bitpacker {
                     continue;
                 }
 
+                if (currentChar == '{') {
+                    const auto gate_and_offset = impl::consume_number(Fmt::value(), i + 2);
+                    ++currentGroup;
+                    currentGate = gate_and_offset.first;
+                    groupOpen = true;
+                    i = gate_and_offset.second;  // the loop skips the ':'
+                    continue;
+                }
+                if (currentChar == '}') {
+                    groupOpen = false;
+                    continue;
+                }
+
                 if (impl::isFormatType(currentChar)) {
                     const auto num_and_offset = impl::consume_number(Fmt::value(), ++i);
                     arr[currentType].formatChar = currentChar;
                     arr[currentType].endian = currentEndian;
                     arr[currentType].count = num_and_offset.first;
                     arr[currentType].offset = offset;
-                    offset += num_and_offset.first;
+                    arr[currentType].repeat = 0;
+                    arr[currentType].counted = false;
+                    arr[currentType].count_field = 0;
+                    arr[currentType].group = groupOpen ? currentGroup : 0;
+                    arr[currentType].gate_field = groupOpen ? currentGate : 0;
+                    i = num_and_offset.second;
+
+                    if (i < Fmt::size() && Fmt::at(i) == '[') {
+                        if (Fmt::at(i + 1) == '#') {
+                            // counted array: `count` stays the element size, the element count is only known at runtime
+                            const auto field_and_offset = impl::consume_number(Fmt::value(), i + 2);
+                            arr[currentType].counted = true;
+                            arr[currentType].count_field = field_and_offset.first;
+                            i = field_and_offset.second + 1;  // skip the closing ']'
+                        }
+                        else {
+                            const auto repeat_and_offset = impl::consume_number(Fmt::value(), i + 1);
+                            arr[currentType].repeat = repeat_and_offset.first;
+                            arr[currentType].count *= repeat_and_offset.first;
+                            i = repeat_and_offset.second + 1;  // skip the closing ']'
+                        }
+                    }
+                    offset += arr[currentType].counted ? 0 : arr[currentType].count;
 
                     ++currentType;
 
-                    i = num_and_offset.second;
                     i--;  // to combat the i++ in the loop
                 }
             }
             return arr;
         }
 
+        /// given an array from `get_type_array()`, remove all the types that represent padding
+        template <size_type N>
+        constexpr auto remove_padding(const std::array< RawFormatType, N > &types) noexcept
+        {
+            std::array< RawFormatType, N > buff{};
+            size_type insert_idx = 0;
+            for (const auto& t : types) {
+                if (!isPadding(t.formatChar)) {
+                    buff[insert_idx++] = t;
+                }
+            }
+            return buff;
+        }
+
+        /// given an array from `get_type_array()`, remove all the types that DON'T represent padding
+        template <size_type N>
+        constexpr auto remove_non_padding(const std::array< RawFormatType, N > &types) noexcept
+        {
+            std::array< RawFormatType, N > buff{};
+            size_type insert_idx = 0;
+            for (const auto& t : types) {
+                if (isPadding(t.formatChar)) {
+                    buff[insert_idx++] = t;
+                }
+            }
+            return buff;
+        }
+
+        /// true if any item of `types` is a counted array (`s14[#0]`)
+        template < size_type N >
+        constexpr bool any_counted(const std::array< RawFormatType, N > &types) noexcept
+        {
+            for (const auto &t : types) {
+                if (t.counted) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /// true if any item of `types` is in an optional group (`{#k:...}`)
+        template < size_type N >
+        constexpr bool any_grouped(const std::array< RawFormatType, N > &types) noexcept
+        {
+            for (const auto &t : types) {
+                if (t.group != 0) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /// bit offset of the first item of `types` in an optional group, or the end of `types` if there are none
+        template < size_type N >
+        constexpr size_type first_group_offset(const std::array< RawFormatType, N > &types) noexcept
+        {
+            for (const auto &t : types) {
+                if (t.group != 0) {
+                    return t.offset;
+                }
+            }
+            return std::numeric_limits< size_type >::max();
+        }
+
+        /// number of bits in `types`, not counting a counted array item (its size is only known at runtime)
+        template < size_type N >
+        constexpr size_type total_bits(const std::array< RawFormatType, N > &types) noexcept
+        {
+            const auto last = types.back();
+            return last.offset + (last.counted ? 0 : last.count);
+        }
+
+        /**
+         * The layout plan of the format Fmt. The format string is validated and parsed here, once per format,
+         * and every other compile time function reads these members instead of parsing the string again.
+         */
+        template < typename Fmt >
+        struct layout {
+            static_assert(validate_format(Fmt{}), "Invalid Format!");
+            static constexpr size_type item_count = impl::count_fmt_items(Fmt{}, true, true);
+            static constexpr size_type field_count = impl::count_fmt_items(Fmt{}, false, true);
+            static constexpr size_type padding_count = item_count - field_count;
+            static constexpr std::array< RawFormatType, item_count > types = impl::parse_type_array< item_count >(Fmt{});
+            static constexpr std::array< RawFormatType, item_count > fields = impl::remove_padding(types);      //< non-padding items first
+            static constexpr std::array< RawFormatType, item_count > padding = impl::remove_non_padding(types); //< padding items first
+            static constexpr impl::Endian byte_order = impl::get_byte_order(Fmt{});
+            static constexpr size_type bits = impl::total_bits(types);
+            static constexpr bool has_counted = impl::any_counted(types);
+            static constexpr bool has_groups = impl::any_grouped(types);
+            static constexpr size_type group_offset = impl::first_group_offset(types);
+        };
+
+        /**
+         * The FormatType of non-padding field `Index` of Fmt. Looking each field up by index in the layout plan, instead
+         * of through a tuple of all the field types, keeps the cost of a format linear in its number of fields.
+         */
+        template < typename Fmt, size_type Index >
+        using field_type = impl::FormatType< layout< Fmt >::fields[Index].formatChar, impl::element_bits(layout< Fmt >::fields[Index]),
+                                             layout< Fmt >::fields[Index].endian, layout< Fmt >::fields[Index].repeat >;
+
+        /// The FormatType of padding item `Index` of Fmt
+        template < typename Fmt, size_type Index >
+        using padding_type = impl::FormatType< layout< Fmt >::padding[Index].formatChar, impl::element_bits(layout< Fmt >::padding[Index]),
+                                               layout< Fmt >::padding[Index].endian, layout< Fmt >::padding[Index].repeat >;
+
+        /// count the number of items in the format
+        template <typename Fmt>
+        constexpr size_type count_all_items(Fmt /*unused*/) noexcept
+        {
+            return layout< Fmt >::item_count;
+        }
+
+        /// count the number of non-padding items in the format
+        template <typename Fmt>
+        constexpr size_type count_non_padding(Fmt /*unused*/) noexcept
+        {
+            return layout< Fmt >::field_count;
+        }
+
+        /// count the number of padding type items in the format
+        template <typename Fmt>
+        constexpr size_type count_padding(Fmt /*unused*/) noexcept
+        {
+            return layout< Fmt >::padding_count;
+        }
+
+        /// the items of the format, in order, see `layout`
+        template < typename Fmt >
+        constexpr auto get_type_array(Fmt /*unused*/) noexcept
+        {
+            return layout< Fmt >::types;
+        }
+
+        /// true if the format has an array item counted by an earlier field (`s14[#0]`)
+        template < typename Fmt >
+        constexpr bool has_counted_item(Fmt /*unused*/) noexcept
+        {
+            return layout< Fmt >::has_counted;
+        }
+
+        /// true if the format has an optional group (`{#k:...}`)
+        template < typename Fmt >
+        constexpr bool has_optional_group(Fmt /*unused*/) noexcept
+        {
+            return layout< Fmt >::has_groups;
+        }
+
+        /// true if the offset of item `t` of Fmt doesn't depend on any optional group
+        template < typename Fmt >
+        constexpr bool is_fixed_offset(const RawFormatType &t) noexcept
+        {
+            return t.group == 0 && t.offset < layout< Fmt >::group_offset;
+        }
+
 /****************************************************************************************************
  * Compile time unpacking implementation
  **************************************************************************************************/
@@ -518,9 +482,56 @@ namespace bitpacker {
         template <typename Fmt, size_type... Items, typename Input>
         constexpr auto unpack(std::index_sequence<Items...> /*unused*/, Input&& packedInput, const size_type start_bit);
 
-        /// does the work of unpacking each type, based on the type passed to UnpackedType
+        /// number of elements of the fixed size array type T (C array or `std::array`), 0 if it isn't known at compile time
+        template < typename T, typename = void >
+        struct static_extent : std::integral_constant< size_type, std::extent< T >::value > {};
+
+        template < typename T >
+        struct static_extent< T, std::void_t< decltype(std::tuple_size< T >::value) > > : std::integral_constant< size_type, std::tuple_size< T >::value > {};
+
+        /// true if the array like type Dest can hold `count` elements, or its size is only known at runtime
+        template < typename Dest >
+        constexpr bool can_hold(const size_type count) noexcept
+        {
+            constexpr size_type extent = static_extent< std::remove_cv_t< Dest > >::value;
+            return extent == 0 || extent >= count;
+        }
+
+        /// unpacks a 'r' or 't' type directly into the array like `buff`
+        template < typename UnpackedType, typename Dest >
+        constexpr void unpack_bytes_into(span< const byte_type > buffer, size_type offset, Dest &buff)
+        {
+            static_assert(isByteType(UnpackedType::format), "Something is wrong :( only raw and text types should get here!");
+            static_assert(impl::can_hold< Dest >(bit2byte(UnpackedType::bits)), "bitpacker: output array is too small for this raw or text field");
+            // to remain binary compatible with bitstruct: bitcount is actual bits.
+            // Any partial bytes end up in the last byte/char, left aligned.
+            constexpr unsigned charsize = 8U;
+            constexpr unsigned full_bytes = UnpackedType::bits / charsize;
+            constexpr unsigned extra_bits = UnpackedType::bits % charsize;
+            constexpr size_type return_size = bit2byte(UnpackedType::bits);
+
+            if (full_bytes > 0) {
+                impl::extract_bytes(buffer, offset, &buff[0], full_bytes);
+            }
+
+            if (extra_bits > 0) {
+                buff[return_size - 1] = extract< uint8_t >(buffer, offset + (full_bytes * charsize), extra_bits);
+                buff[return_size - 1] <<= charsize - extra_bits;
+            }
+
+            // little endian bitwise in bitstruct means the entire length flipped.
+            // to simulate this we reverse the order then flip each bytes bit order
+            if (UnpackedType::bit_endian == impl::Endian::little) {
+                bitpacker::impl::reverse(&buff[0], &buff[0] + return_size);
+                for (size_type i = 0; i < return_size; ++i) {
+                    buff[i] = impl::reverse_bits< std::remove_reference_t< decltype(buff[i]) >, ByteSize >(buff[i]);
+                }
+            }
+        }
+
+        /// does the work of unpacking a single value, based on the type passed to UnpackedType
         template < typename UnpackedType >
-        constexpr auto unpackElement(span< const byte_type > buffer, size_type offset) -> typename UnpackedType::return_type
+        constexpr auto unpackValue(span< const byte_type > buffer, size_type offset) -> typename UnpackedType::return_type
         {
             // TODO: Implement float unpacking
             static_assert(UnpackedType::format != 'f', "Unpacking Floats not supported yet...");
@@ -547,68 +558,53 @@ namespace bitpacker {
                               "Expected float size of 16, 32, or 64 bits");
             }
             if constexpr (isByteType(UnpackedType::format)) {
-                // to remain binary compatible with bitstruct: bitcount is actual bits.
-                // Any partial bytes end up in the last byte/char, left aligned.
-                constexpr unsigned charsize = 8U;
-                constexpr unsigned full_bytes = UnpackedType::bits / charsize;
-                constexpr unsigned extra_bits = UnpackedType::bits % charsize;
-                constexpr size_type return_size = bit2byte(UnpackedType::bits);
                 typename UnpackedType::return_type buff{};
-                
-                for (size_type i = 0; i < full_bytes; ++i) {
-                    buff[i] = extract< uint8_t >(buffer, offset + (i * charsize), charsize);
-                }
-
-                if (extra_bits > 0) {
-                    buff[return_size - 1] = extract< uint8_t >(buffer, offset + (full_bytes * charsize), extra_bits);
-                    buff[return_size - 1] <<= charsize - extra_bits; 
-                }
-
-                // little endian bitwise in bitstruct means the entire length flipped.
-                // to simulate this we reverse the order then flip each bytes bit order
-                if (UnpackedType::bit_endian == impl::Endian::little) {
-                    bitpacker::impl::reverse(buff.begin(), buff.end());
-                    for (auto &v : buff) {
-                        v = impl::reverse_bits< decltype(v), ByteSize >(v);
-                    }
-                }
-
+                impl::unpack_bytes_into< UnpackedType >(buffer, offset, buff);
                 return buff;
             }
         }
 
-        /// given an array from `get_type_array()`, remove all the types that represent padding
-        template <size_type N>
-        constexpr auto remove_padding(const std::array< RawFormatType, N > &types) noexcept
+        /// does the work of unpacking each type, based on the type passed to UnpackedType. Array items unpack element by element.
+        template < typename UnpackedType >
+        constexpr auto unpackElement(span< const byte_type > buffer, size_type offset) -> typename UnpackedType::return_type
         {
-            std::array< RawFormatType, N > buff{};
-            size_type insert_idx = 0;
-            for (const auto& t : types) {
-                if (!isPadding(t.formatChar)) {
-                    buff[insert_idx++] = t;
+            if constexpr (UnpackedType::repeat != 0) {
+                using Element = typename UnpackedType::element;
+                typename UnpackedType::return_type arr{};
+                for (size_type i = 0; i < UnpackedType::repeat; ++i) {
+                    arr[i] = impl::unpackValue< Element >(buffer, offset + (i * Element::bits));
                 }
+                return arr;
+            }
+            else {
+                return impl::unpackValue< UnpackedType >(buffer, offset);
             }
-            return buff;
         }
 
-/***************************************************************************************************
-* Compile time packing implementation
-***************************************************************************************************/
-
-        /// given an array from `get_type_array()`, remove all the types that DON'T represent padding
-        template <size_type N>
-        constexpr auto remove_non_padding(const std::array< RawFormatType, N > &types) noexcept
+        /// unpacks the type UnpackedType directly into `out`, without an intermediate copy for 'r' and 't' types
+        template < typename UnpackedType, typename Output >
+        constexpr int unpackElementInto(span< const byte_type > buffer, size_type offset, Output &out)
         {
-            std::array< RawFormatType, N > buff{};
-            size_type insert_idx = 0;
-            for (const auto& t : types) {
-                if (isPadding(t.formatChar)) {
-                    buff[insert_idx++] = t;
+            if constexpr (UnpackedType::repeat != 0) {
+                static_assert(impl::can_hold< Output >(UnpackedType::repeat), "bitpacker: output array has fewer elements than this array item");
+                using Element = typename UnpackedType::element;
+                for (size_type i = 0; i < UnpackedType::repeat; ++i) {
+                    impl::unpackElementInto< Element >(buffer, offset + (i * Element::bits), out[i]);
                 }
             }
-            return buff;
+            else if constexpr (isByteType(UnpackedType::format)) {
+                impl::unpack_bytes_into< UnpackedType >(buffer, offset, out);
+            }
+            else {
+                out = impl::unpackElement< UnpackedType >(buffer, offset);
+            }
+            return 0;
         }
 
+/***************************************************************************************************
+* Compile time packing implementation
+***************************************************************************************************/
+
         /// basic conversion function. Allows for custom specialization in the future?
         template <typename RepType, typename T>
         constexpr RepType convert_for_pack(const T& val)
@@ -616,9 +612,9 @@ namespace bitpacker {
             return static_cast<RepType>(val);
         }
 
-        /// does the work of packing `elem`, based on the type passed to PackedType
+        /// does the work of packing a single value `elem`, based on the type passed to PackedType
         template <typename PackedType, typename InputType>
-        constexpr int packElement(span<byte_type> buffer, size_type offset, InputType elem)
+        constexpr int packValue(span<byte_type> buffer, size_type offset, InputType elem)
         {
             // TODO: Implement float packing
             static_assert(PackedType::format != 'f', "Unpacking Floats not supported yet...");
@@ -672,52 +668,299 @@ namespace bitpacker {
                         v = impl::reverse_bits< decltype(v), ByteSize >(v);
                     }
 
-                    for(int bits = PackedType::bits, idx = 0; bits > 0; bits -= charsize) {
-                        const auto field_size = bits < charsize ? bits : charsize;
-                        insert<uint8_t>(buffer, offset + (idx * charsize), charsize, arr[idx]);
-                        ++idx;
+                    impl::insert_bytes(buffer, offset, arr.data(), full_bytes);
+                    if (extra_bits > 0) {
+                        // partial bytes are left aligned, only the upper `extra_bits` bits belong to the field
+                        insert<uint8_t>(buffer, offset + (full_bytes * charsize), extra_bits, static_cast<uint8_t>(arr[full_bytes] >> (charsize - extra_bits)));
                     }
                 }
                 else {
-                    for(int bits = PackedType::bits, idx = 0; bits > 0; bits -= charsize) {
-                        const auto field_size = bits < charsize ? bits : charsize;
-                        insert<uint8_t>(buffer, offset + (idx * charsize), charsize, elem[idx]);
-                        ++idx;
+                    impl::insert_bytes(buffer, offset, &elem[0], full_bytes);
+                    if (extra_bits > 0) {
+                        insert<uint8_t>(buffer, offset + (full_bytes * charsize), extra_bits, static_cast<uint8_t>(static_cast<uint8_t>(elem[full_bytes]) >> (charsize - extra_bits)));
                     }
                 }
             }
             return 0;
         }
 
-        /// Helper function to insert padding fields into the buffer for `pack_into()`
-        template <typename Fmt, size_type... Items>
-        constexpr auto insert_padding(span<byte_type> buffer, const size_type start_bit, std::index_sequence<Items...> /*unused*/)
+        /// does the work of packing `elem`, based on the type passed to PackedType. Array items pack element by element.
+        template <typename PackedType, typename InputType>
+        constexpr int packElement(span<byte_type> buffer, size_type offset, const InputType &elem)
         {
-            constexpr auto formats_only_pad = impl::remove_non_padding(impl::get_type_array(Fmt{}));
-            using FormatTypes = std::tuple< typename impl::FormatType< formats_only_pad[Items].formatChar,
-                                                                       formats_only_pad[Items].count,
-                                                                       formats_only_pad[Items].endian >... >;
-            int _[] = { 0, packElement< std::tuple_element_t<Items, FormatTypes> >(buffer, formats_only_pad[Items].offset + start_bit, 0)... };
-            (void)_; // _ is a dummy for pack expansion
+            if constexpr (PackedType::repeat != 0) {
+                using Element = typename PackedType::element;
+                for (size_type i = 0; i < PackedType::repeat; ++i) {
+                    if constexpr (isPadding(PackedType::format)) {
+                        impl::packValue< Element >(buffer, offset + (i * Element::bits), elem);
+                    }
+                    else {
+                        impl::packValue< Element >(buffer, offset + (i * Element::bits), elem[i]);
+                    }
+                }
+                return 0;
+            }
+            else {
+                return impl::packValue< PackedType >(buffer, offset, elem);
+            }
         }
 
-        /// helper function to pack types into the given buffer
-        template <typename Fmt, size_type N, size_type... Items, typename... Args>
-        constexpr void pack(std::array<byte_type, N>& output, const size_type start_bit, std::index_sequence<Items...> /*unused*/, Args&&... args)
-        {
-            static_assert(sizeof...(args) == sizeof...(Items), "pack expected items for packing != sizeof...(args) passed");
-            constexpr auto byte_order = impl::get_byte_order(Fmt{});
-            static_assert(byte_order == impl::Endian::big, "Unpacking little endian byte order not supported yet...");
-            constexpr auto formats_no_pad   = impl::remove_padding(impl::get_type_array(Fmt{}));
-
-            using FormatTypes = std::tuple< typename impl::FormatType< formats_no_pad[Items].formatChar,
-                                                                       formats_no_pad[Items].count,
-                                                                       formats_no_pad[Items].endian >... >;
+/***************************************************************************************************
+* Size optimized kernels (BITPACKER_OPTIMIZE_SIZE)
+***************************************************************************************************/
 
-            impl::insert_padding<Fmt>( output, start_bit, std::make_index_sequence<impl::count_padding(Fmt{})>());
-            int _[] = { 0, packElement< std::tuple_element_t<Items, FormatTypes> >(output, formats_no_pad[Items].offset + start_bit, args)... };
-            (void)_; // _ is a dummy for pack expansion
-        }
+#if defined(BITPACKER_OPTIMIZE_SIZE)
+        /// true to pack and unpack integer and bool fields with the shared kernels below, see `BITPACKER_OPTIMIZE_SIZE`
+        constexpr bool optimize_size = true;
+#else
+        constexpr bool optimize_size = false;
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+# define BITPACKER_NOINLINE  __attribute__((noinline))
+#elif defined(_MSC_VER)
+# define BITPACKER_NOINLINE  __declspec(noinline)
+#else
+# define BITPACKER_NOINLINE
+#endif
+
+        /// one element of a 'u', 's', 'b' or padding item, reduced to what the shared kernels need
+        struct item_op {
+            uint32_t offset;    //< offset of the element from the start of the format in bits
+            uint8_t bits;       //< number of bits in the element
+            char format;        //< the format character of the item
+            bool lsb_first;     //< bit order is `<`
+        };
+
+        /**
+         * Read the 'u', 's' or 'b' elements `ops[0, count)` of a format starting at `start_bit` into `values`.
+         * Not a template, so every format shares one copy. Signed values are sign extended and bools are 0 or 1.
+         */
+        BITPACKER_NOINLINE constexpr void read_items(span< const byte_type > buffer, const size_type start_bit,
+                                                     const item_op *ops, const size_type count, uint64_t *values) noexcept
+        {
+            for (size_type i = 0; i < count; ++i) {
+                const item_op op = ops[i];
+                const unsigned bits = op.bits;
+                uint64_t v = extract< uint64_t >(buffer, start_bit + op.offset, bits);
+                if (op.lsb_first) {
+                    v = impl::reverse_bits< uint64_t, 64 >(v) >> (64U - bits);
+                }
+                if (op.format == 's' && bits < 64U) {
+                    const uint64_t sign = uint64_t{1} << (bits - 1U);
+                    v = (v ^ sign) - sign;
+                }
+                values[i] = op.format == 'b' ? static_cast< uint64_t >(v != 0) : v;
+            }
+        }
+
+        /**
+         * Write the elements `ops[0, count)` of a format starting at `start_bit`. Element `i` takes `values[i]`, except
+         * padding, which is filled with zeros or ones and doesn't read `values`. Not a template, so every format shares one copy.
+         */
+        BITPACKER_NOINLINE constexpr void write_items(span< byte_type > buffer, const size_type start_bit,
+                                                      const item_op *ops, const size_type count, const uint64_t *values) noexcept
+        {
+            for (size_type i = 0; i < count; ++i) {
+                const item_op op = ops[i];
+                const unsigned bits = op.bits;
+                uint64_t v = 0;
+                if (isPadding(op.format)) {
+                    v = op.format == 'P' ? ~uint64_t{0} : 0;
+                }
+                else {
+                    v = op.format == 'b' ? static_cast< uint64_t >(values[i] != 0) : values[i];
+                }
+                if (bits < 64U) {
+                    v &= (uint64_t{1} << bits) - 1U;
+                }
+                if (op.lsb_first) {
+                    v = impl::reverse_bits< uint64_t, 64 >(v) >> (64U - bits);
+                }
+                insert< uint64_t >(buffer, start_bit + op.offset, bits, v);
+            }
+        }
+
+        /// number of elements in the first `count` items of `types`
+        template < size_type N >
+        constexpr size_type count_elements(const std::array< RawFormatType, N > &types, const size_type count) noexcept
+        {
+            size_type elements = 0;
+            for (size_type i = 0; i < count; ++i) {
+                elements += types[i].repeat != 0 ? types[i].repeat : 1;
+            }
+            return elements;
+        }
+
+        /// true if the first `count` items of `types` can all go through `read_items()`/`write_items()`
+        template < size_type N >
+        constexpr bool kernel_items(const std::array< RawFormatType, N > &types, const size_type count) noexcept
+        {
+            for (size_type i = 0; i < count; ++i) {
+                const auto &t = types[i];
+                if (isByteType(t.formatChar) || t.formatChar == 'f' || t.counted || t.group != 0 || impl::element_bits(t) > 64
+                    || t.offset + t.count > std::numeric_limits< uint32_t >::max()) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /// the kernel operations for every element of the non-padding items, then every element of the padding items
+        template < size_type Count, typename Fmt >
+        constexpr auto make_item_ops(Fmt /*unused*/) noexcept
+        {
+            using layout = impl::layout< Fmt >;
+            std::array< item_op, Count > ops{};
+            size_type op = 0;
+            const auto append = [&ops, &op](const RawFormatType &t) {
+                const size_type bits = impl::element_bits(t);
+                for (size_type e = 0; e < (t.repeat != 0 ? t.repeat : 1); ++e) {
+                    ops[op++] = { static_cast< uint32_t >(t.offset + (e * bits)), static_cast< uint8_t >(bits), t.formatChar,
+                                  t.endian == impl::Endian::little };
+                }
+            };
+            for (size_type i = 0; i < layout::field_count; ++i) {
+                append(layout::fields[i]);
+            }
+            for (size_type i = 0; i < layout::padding_count; ++i) {
+                append(layout::padding[i]);
+            }
+            return ops;
+        }
+
+        /// index of the first value of each non-padding item in the `read_items()`/`write_items()` values
+        template < size_type Count, size_type N >
+        constexpr auto make_first_values(const std::array< RawFormatType, N > &types) noexcept
+        {
+            std::array< size_type, Count > first{};
+            size_type value = 0;
+            for (size_type i = 0; i < Count; ++i) {
+                first[i] = value;
+                value += types[i].repeat != 0 ? types[i].repeat : 1;
+            }
+            return first;
+        }
+
+        /**
+         * The table the shared kernels run over for the format Fmt, used when `BITPACKER_OPTIMIZE_SIZE` is defined.
+         * Formats with 'r', 't' or 'f' items, counted arrays or optional groups keep the per field code.
+         */
+        template < typename Fmt >
+        struct item_table {
+            using layout = impl::layout< Fmt >;
+            static constexpr bool enabled = optimize_size && impl::kernel_items(layout::types, layout::item_count);
+            static constexpr size_type value_count = impl::count_elements(layout::fields, layout::field_count);
+            static constexpr size_type op_count = value_count + impl::count_elements(layout::padding, layout::padding_count);
+            static constexpr std::array< item_op, op_count > ops = impl::make_item_ops< op_count >(Fmt{});
+            static constexpr std::array< size_type, layout::field_count > first_value = impl::make_first_values< layout::field_count >(layout::fields);
+        };
+
+        /// convert the values from `read_items()` of non-padding field Index of Fmt, starting at `values`, to the field's type
+        template < typename Fmt, size_type Index, typename Output >
+        constexpr int item_result(const uint64_t *values, Output &out) noexcept
+        {
+            using T = impl::field_type< Fmt, Index >;
+            if constexpr (T::repeat == 0) {
+                out = static_cast< typename T::return_type >(values[0]);
+            }
+            else {
+                for (size_type i = 0; i < T::repeat; ++i) {
+                    out[i] = static_cast< typename T::element::return_type >(values[i]);
+                }
+            }
+            return 0;
+        }
+
+        template < typename Fmt, size_type Index >
+        constexpr auto item_result(const uint64_t *values) noexcept
+        {
+            typename impl::field_type< Fmt, Index >::return_type out{};
+            impl::item_result< Fmt, Index >(values, out);
+            return out;
+        }
+
+        /// the value `elem` as the 64 bit pattern `write_items()` takes for an element of type PackedType
+        template < typename PackedType, typename InputType >
+        constexpr uint64_t item_value(const InputType &elem)
+        {
+            if constexpr (PackedType::format == 'b') {
+                return static_cast< uint64_t >(static_cast< bool >(elem));
+            }
+            else {
+                return static_cast< uint64_t >(impl::convert_for_pack< typename PackedType::rep_type >(elem));
+            }
+        }
+
+        /// store the value(s) `elem` of non-padding field Index of Fmt where `write_items()` expects them
+        template < typename Fmt, size_type Index, size_type N, typename InputType >
+        constexpr int item_values(std::array< uint64_t, N > &values, const InputType &elem)
+        {
+            using T = impl::field_type< Fmt, Index >;
+            constexpr size_type first = impl::item_table< Fmt >::first_value[Index];
+            if constexpr (T::repeat == 0) {
+                values[first] = impl::item_value< T >(elem);
+            }
+            else {
+                for (size_type i = 0; i < T::repeat; ++i) {
+                    values[first + i] = impl::item_value< typename T::element >(elem[i]);
+                }
+            }
+            return 0;
+        }
+
+        /// unpack non-padding field Index of Fmt, from a format starting at `start_bit`
+        template < typename Fmt, size_type Index >
+        constexpr auto unpack_field(span< const byte_type > buffer, const size_type start_bit) -> typename field_type< Fmt, Index >::return_type
+        {
+            using table = impl::item_table< Fmt >;
+            using T = impl::field_type< Fmt, Index >;
+            if constexpr (table::enabled) {
+                constexpr size_type elements = T::repeat != 0 ? T::repeat : 1;
+                std::array< uint64_t, elements > values{};
+                impl::read_items(buffer, start_bit, table::ops.data() + table::first_value[Index], elements, values.data());
+                return impl::item_result< Fmt, Index >(values.data());
+            }
+            else {
+                return impl::unpackElement< T >(buffer, start_bit + impl::layout< Fmt >::fields[Index].offset);
+            }
+        }
+
+        /// Helper function to insert padding fields into the buffer for `pack_into()`
+        template <typename Fmt, size_type... Items>
+        constexpr auto insert_padding(span<byte_type> buffer, const size_type start_bit, std::index_sequence<Items...> /*unused*/)
+        {
+            constexpr const auto &formats_only_pad = impl::layout< Fmt >::padding;
+            int _[] = { 0, packElement< impl::padding_type< Fmt, Items > >(buffer, formats_only_pad[Items].offset + start_bit, 0)... };
+            (void)_; // _ is a dummy for pack expansion
+        }
+
+        /// helper function to pack types into the given buffer
+        template <typename Fmt, size_type... Items, typename... Args>
+        constexpr void pack(span<byte_type> output, const size_type start_bit, std::index_sequence<Items...> /*unused*/, Args&&... args)
+        {
+            static_assert(sizeof...(args) == sizeof...(Items), "pack expected items for packing != sizeof...(args) passed");
+            static_assert(!impl::has_counted_item(Fmt{}) || sizeof...(Items) < impl::count_non_padding(Fmt{}),
+                          "formats with a counted array item ('[#k]') can only be used with unpack_counted() and pack_counted_into()");
+            static_assert(!impl::has_optional_group(Fmt{}), "formats with an optional group ('{#k:...}') can only be used with unpack_optional() and pack_optional_into()");
+            constexpr auto byte_order = impl::layout< Fmt >::byte_order;
+            static_assert(byte_order == impl::Endian::big, "Unpacking little endian byte order not supported yet...");
+
+            using table = impl::item_table< Fmt >;
+            if constexpr (table::enabled && sizeof...(Items) == impl::count_non_padding(Fmt{})) {
+                // one call into the shared kernel writes every field and the padding
+                std::array< uint64_t, table::value_count > values{};
+                int _[] = { 0, impl::item_values< Fmt, Items >(values, args)... };
+                (void)_; // _ is a dummy for pack expansion
+                impl::write_items(output, start_bit, table::ops.data(), table::op_count, values.data());
+            }
+            else {
+                constexpr const auto &formats_no_pad = impl::layout< Fmt >::fields;
+                impl::insert_padding<Fmt>( output, start_bit, std::make_index_sequence<impl::count_padding(Fmt{})>());
+                int _[] = { 0, packElement< impl::field_type< Fmt, Items > >(output, formats_no_pad[Items].offset + start_bit, args)... };
+                (void)_; // _ is a dummy for pack expansion
+            }
+        }
 
     }   // namespace impl
 
@@ -733,9 +976,8 @@ namespace bitpacker {
     template < typename Fmt >
     constexpr size_type calcsize(Fmt /*unused*/)
     {
-        constexpr auto type_array = impl::get_type_array(Fmt{});
-        const auto last = type_array.back();
-        return last.offset + last.count;
+        // a counted array item only adds bits at runtime, see `bitpacker::packed_size()`
+        return impl::layout< Fmt >::bits;
     }
 
     /**
@@ -750,12 +992,233 @@ namespace bitpacker {
         return impl::bit2byte(bits);
     }
 
+    namespace impl {
+
+        /// a null terminated character array holding a format string built at compile time
+        template < size_type Length >
+        struct format_chars {
+            char data[Length + 1];
+        };
+
+        /**
+         * Number of characters of Fmt that are copied when it is concatenated with other formats. Only the last
+         * format keeps its trailing byte order character, since byte order applies to the message as a whole.
+         */
+        template < typename Fmt >
+        constexpr size_type concat_copy_length(const bool last) noexcept
+        {
+            return (!last && Fmt::size() > 0 && impl::isFormatMode(Fmt::at(Fmt::size() - 1))) ? Fmt::size() - 1 : Fmt::size();
+        }
+
+        /// number of decimal digits needed to write `value`
+        constexpr size_type decimal_digits(size_type value) noexcept
+        {
+            size_type digits = 1;
+            for (; value >= 10; value /= 10) {
+                ++digits;
+            }
+            return digits;
+        }
+
+        /**
+         * Number of characters written for Fmt in a concatenated format. Field references (`[#k]` and `{#k:`)
+         * count fields from the start of the combined format, so k grows by `field_base`, the number of
+         * non-padding fields in the formats before Fmt, and may need more digits.
+         */
+        template < typename Fmt >
+        constexpr size_type concat_written_length(const bool last, const size_type field_base) noexcept
+        {
+            const size_type copy_length = concat_copy_length< Fmt >(last);
+            size_type length = 0;
+            for (size_type i = 0; i < copy_length; ++i) {
+                ++length;
+                if (Fmt::at(i) == '#') {
+                    const auto field_and_offset = impl::consume_number(Fmt::value(), i + 1);
+                    length += decimal_digits(field_and_offset.first + field_base);
+                    i = field_and_offset.second - 1;
+                }
+            }
+            return length;
+        }
+
+        /// true if a '>' must be inserted before Fmt so it starts with the default (MSB first) bit order
+        template < typename Fmt >
+        constexpr bool concat_needs_bit_order(const bool first) noexcept
+        {
+            return !first && (Fmt::size() == 0 || !impl::isFormatMode(Fmt::at(0)));
+        }
+
+        /// number of non-padding fields in the formats before format `Index` of Fmts...
+        template < typename... Fmts >
+        constexpr size_type concat_field_base(const size_type index) noexcept
+        {
+            constexpr size_type field_counts[] = { impl::count_non_padding(Fmts{})... };
+            size_type base = 0;
+            for (size_type i = 0; i < index; ++i) {
+                base += field_counts[i];
+            }
+            return base;
+        }
+
+        template < typename... Fmts, size_type... Idx >
+        constexpr size_type concat_length(std::index_sequence< Idx... > /*unused*/) noexcept
+        {
+            constexpr size_type last = sizeof...(Fmts) - 1;
+            return (size_type{0} + ... + (concat_written_length< Fmts >(Idx == last, concat_field_base< Fmts... >(Idx))
+                                          + (concat_needs_bit_order< Fmts >(Idx == 0) ? 1 : 0)));
+        }
+
+        template < typename Fmt, size_type Length >
+        constexpr size_type append_format(format_chars< Length > &out, size_type pos, const bool first, const bool last,
+                                          const size_type field_base) noexcept
+        {
+            if (concat_needs_bit_order< Fmt >(first)) {
+                out.data[pos++] = '>';
+            }
+            const size_type copy_length = concat_copy_length< Fmt >(last);
+            for (size_type i = 0; i < copy_length; ++i) {
+                out.data[pos++] = Fmt::at(i);
+                if (Fmt::at(i) == '#') {
+                    // renumber the field reference so it still points at the same field in the combined format
+                    const auto field_and_offset = impl::consume_number(Fmt::value(), i + 1);
+                    size_type field = field_and_offset.first + field_base;
+                    const size_type digits = decimal_digits(field);
+                    for (size_type d = digits; d > 0; --d, field /= 10) {
+                        out.data[pos + d - 1] = static_cast< char >('0' + (field % 10));
+                    }
+                    pos += digits;
+                    i = field_and_offset.second - 1;
+                }
+            }
+            return pos;
+        }
+
+        template < size_type Length, typename... Fmts, size_type... Idx >
+        constexpr auto concat_chars(std::index_sequence< Idx... > /*unused*/) noexcept
+        {
+            constexpr size_type last = sizeof...(Fmts) - 1;
+            format_chars< Length > out{};
+            size_type pos = 0;
+            int _[] = { 0, (pos = append_format< Fmts >(out, pos, Idx == 0, Idx == last, concat_field_base< Fmts... >(Idx)), 0)... };
+            (void)_; // _ is a dummy for pack expansion
+            return out;
+        }
+
+        template < typename... Fmts >
+        constexpr bool same_byte_order() noexcept
+        {
+            constexpr impl::Endian orders[] = { impl::get_byte_order(Fmts{})... };
+            for (const auto order : orders) {
+                if (order != orders[0]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /// format type made of the format strings Fmts... back to back, see `bitpacker::concat()`
+        template < typename... Fmts >
+        struct concat_format : format_string {
+            static constexpr size_type length = impl::concat_length< Fmts... >(std::index_sequence_for< Fmts... >());
+            static constexpr format_chars< length > chars = impl::concat_chars< length, Fmts... >(std::index_sequence_for< Fmts... >());
+
+            static constexpr decltype(auto) value() { return (chars.data); }
+            static constexpr size_type size() { return length; }
+            static constexpr auto at(size_type i) { return value()[i]; }
+        };
+
+    }  // namespace impl
+
+    /**
+     * Compose a single format out of several formats laid out back to back, for example a common header and
+     * a payload. Each format keeps its own bit order, and the result behaves like one format string: the field
+     * offsets are folded into one layout, so packing the result is a single pass over the output.
+     * Field references (`[#k]` and `{#k:...}`) keep pointing at the same field: k is renumbered to count the
+     * fields of the earlier formats too. The result can be concatenated again.
+     * @param fmts... [IN] format strings created with macro `BP_STRING()` (or `concat()`), all with the same byte order
+     * @return format type for the combined format
+     */
+    template < typename... Fmts >
+    constexpr auto concat(Fmts... /*unused*/) noexcept
+    {
+        static_assert(sizeof...(Fmts) > 0, "bitpacker::concat : at least one format is needed");
+        static_assert((std::is_base_of< impl::format_string, Fmts >::value && ...),
+                      "bitpacker::concat : arguments must be formats created with BP_STRING()");
+        static_assert(impl::same_byte_order< Fmts... >(), "bitpacker::concat : all formats must have the same byte order");
+        return impl::concat_format< Fmts... >{};
+    }
+
+    namespace impl {
+
+        /// formats with more non-padding fields than this unpack to a `large_record`, a `std::tuple` that big is slow to compile
+        constexpr size_type max_tuple_fields = 128;
+
+        /// one field of a `large_record`
+        template < size_type Index, typename T >
+        struct record_leaf {
+            T value{};
+        };
+
+        template < typename Fmt, typename Seq >
+        struct record_fields;
+
+        template < typename Fmt, size_type... Items >
+        struct record_fields< Fmt, std::index_sequence< Items... > > : record_leaf< Items, typename impl::field_type< Fmt, Items >::return_type >... {};
+
+    }  // namespace impl
+
+    /**
+     * Result of `unpack()` for formats with more than 128 non-padding fields. Holds the same values as the tuple
+     * would, but the fields are flat base classes instead of a recursive `std::tuple`, so it compiles in time linear in
+     * the number of fields. Read field `I` with `bitpacker::get<I>(record)`; structured bindings are supported too.
+     */
+    template < typename Fmt >
+    struct large_record : impl::record_fields< Fmt, std::make_index_sequence< impl::count_non_padding(Fmt{}) > > {
+        static constexpr size_type field_count = impl::count_non_padding(Fmt{});
+    };
+
+    /// non-padding field `I` of a `large_record`
+    template < size_type I, typename Fmt >
+    constexpr auto &get(large_record< Fmt > &record) noexcept
+    {
+        return static_cast< impl::record_leaf< I, typename impl::field_type< Fmt, I >::return_type > & >(record).value;
+    }
+
+    template < size_type I, typename Fmt >
+    constexpr const auto &get(const large_record< Fmt > &record) noexcept
+    {
+        return static_cast< const impl::record_leaf< I, typename impl::field_type< Fmt, I >::return_type > & >(record).value;
+    }
+
+    namespace impl {
+
+        template < typename Fmt, size_type... Items >
+        constexpr bool equal_records(const large_record< Fmt > &lhs, const large_record< Fmt > &rhs, std::index_sequence< Items... > /*unused*/)
+        {
+            return ((bitpacker::get< Items >(lhs) == bitpacker::get< Items >(rhs)) && ...);
+        }
+
+    }  // namespace impl
+
+    template < typename Fmt >
+    constexpr bool operator==(const large_record< Fmt > &lhs, const large_record< Fmt > &rhs)
+    {
+        return impl::equal_records(lhs, rhs, std::make_index_sequence< large_record< Fmt >::field_count >());
+    }
+
+    template < typename Fmt >
+    constexpr bool operator!=(const large_record< Fmt > &lhs, const large_record< Fmt > &rhs)
+    {
+        return !(lhs == rhs);
+    }
+
     /**
      * Unpack packedInput (container of bytes) according to given
      * format string fmt. The result is a tuple even if it contains exactly one item.
+     * Formats with more than 128 non-padding fields unpack to a `large_record` instead of a tuple.
      * @param fmt [IN] format string created with macro `BP_STRING()`
      * @param packedInput [IN] container of byte types
-     * @return tuple of results according to format string
+     * @return tuple (or `large_record`) of results according to format string
      */
     template < typename Fmt, typename Input >
     constexpr auto unpack(Fmt /*unused*/, Input &&packedInput)
@@ -767,11 +1230,11 @@ namespace bitpacker {
     /**
      * Unpack packedInput (container of bytes) according to
      * given format string fmt, starting at given bit offset offset.
-     * The result is a tuple even if it contains exactly one item.
+     * The result is a tuple even if it contains exactly one item, or a `large_record` for more than 128 fields.
      * @param fmt [IN] format string created with macro `BP_STRING()`
      * @param packedInput [IN] container of byte types
      * @param offset [IN] bit index to start unpacking from
-     * @return tuple of results according to format string
+     * @return tuple (or `large_record`) of results according to format string
      */
     template < typename Fmt, typename Input >
     constexpr auto unpack_from(Fmt /*unused*/, Input &&packedInput, const size_type offset)
@@ -783,50 +1246,2027 @@ namespace bitpacker {
     template < typename Fmt, size_t... Items, typename Input >
     constexpr auto impl::unpack(std::index_sequence< Items... > /*unused*/, Input &&packedInput, const size_t start_bit)
     {
-        constexpr auto byte_order = impl::get_byte_order(Fmt{});
+        static_assert(!impl::has_counted_item(Fmt{}) || sizeof...(Items) < impl::count_non_padding(Fmt{}),
+                      "formats with a counted array item ('[#k]') can only be used with unpack_counted() and pack_counted_into()");
+        static_assert(!impl::has_optional_group(Fmt{}), "formats with an optional group ('{#k:...}') can only be used with unpack_optional() and pack_optional_into()");
+        constexpr auto byte_order = impl::layout< Fmt >::byte_order;
         static_assert(byte_order == impl::Endian::big, "Unpacking little endian byte order not supported yet...");
-        constexpr auto formats = impl::remove_padding(impl::get_type_array(Fmt{}));
 
-        using FormatTypes = std::tuple< typename impl::FormatType< formats[Items].formatChar, formats[Items].count, formats[Items].endian >... >;
+        // NOLINTNEXTLINE - this is the standard implementation of std::as_bytes() from c++20
+        const span< const byte_type > input{reinterpret_cast<const byte_type*>(std::data(packedInput)), std::size(packedInput)};
+        using table = impl::item_table< Fmt >;
+        if constexpr (sizeof...(Items) > impl::max_tuple_fields && sizeof...(Items) == impl::count_non_padding(Fmt{})) {
+            large_record< Fmt > result{};
+            if constexpr (table::enabled) {
+                std::array< uint64_t, table::value_count > values{};
+                impl::read_items(input, start_bit, table::ops.data(), table::value_count, values.data());
+                int _[] = { 0, impl::item_result< Fmt, Items >(values.data() + table::first_value[Items], bitpacker::get< Items >(result))... };
+                (void)_; // _ is a dummy for pack expansion
+            }
+            else {
+                constexpr const auto &formats = impl::layout< Fmt >::fields;
+                int _[] = { 0, impl::unpackElementInto< impl::field_type< Fmt, Items > >(input, formats[Items].offset + start_bit, bitpacker::get< Items >(result))... };
+                (void)_; // _ is a dummy for pack expansion
+            }
+            return result;
+        }
+        else if constexpr (table::enabled && sizeof...(Items) == impl::count_non_padding(Fmt{})) {
+            // one call into the shared kernel reads every field
+            std::array< uint64_t, table::value_count > values{};
+            impl::read_items(input, start_bit, table::ops.data(), table::value_count, values.data());
+            return std::make_tuple(impl::item_result< Fmt, Items >(values.data() + table::first_value[Items])...);
+        }
+        else {
+            constexpr const auto &formats = impl::layout< Fmt >::fields;
+            return std::make_tuple(impl::unpackElement< impl::field_type< Fmt, Items > >(input, formats[Items].offset + start_bit)...);
+        }
+    }
+
+    namespace impl {
+
+        /// layout of non-padding field `Index` of the format Fmt (same numbering as the tuple from `unpack`)
+        template < typename Fmt, size_type Index >
+        struct field_info {
+            static_assert(Index < impl::count_non_padding(Fmt{}), "field index out of range for this format");
+            static constexpr const auto &formats = impl::layout< Fmt >::fields;
+            static_assert(!formats[Index].counted, "a counted array item ('[#k]') has no fixed layout, use unpack_counted()");
+            static_assert(impl::is_fixed_offset< Fmt >(formats[Index]), "fields in or after an optional group ('{#k:...}') have no fixed layout, use unpack_optional()");
+            static constexpr size_type offset = formats[Index].offset;
+            using type = impl::field_type< Fmt, Index >;
+
+            /// true if the field is a raw or text field that is stored as whole bytes, in order, on a byte boundary.
+            /// Such a field can be viewed in place instead of being copied out.
+            static constexpr bool is_byte_view = isByteType(formats[Index].formatChar) && formats[Index].repeat == 0 && formats[Index].endian == impl::Endian::big
+                                                 && impl::is_aligned(formats[Index].offset) && impl::is_aligned(formats[Index].count);
+        };
+
+        /**
+         * The bytes of the byte aligned raw or text field Index of a record at bit `offset` in buffer, or an empty
+         * span if the record doesn't start on a byte boundary or buffer is too short to hold the field.
+         */
+        template < typename Fmt, size_type Index, typename Byte >
+        constexpr span< Byte > field_bytes(span< Byte > buffer, const size_type offset) noexcept
+        {
+            using field = impl::field_info< Fmt, Index >;
+            constexpr size_type length = field::type::bits / ByteSize;
+            const size_type first = (offset + field::offset) / ByteSize;
+            if (!impl::is_aligned(offset) || buffer.size() < first + length) {
+                return {};
+            }
+            return buffer.subspan(first, length);
+        }
+
+        /// largest aggregate that can be used with `as_tie()`
+        constexpr size_type max_tie_members = 32;
+
+        /**
+         * Create a tuple of references to the `N` members of the aggregate `obj`, using structured bindings.
+         * `N` must be the exact number of members. This allows aggregates to be used anywhere a list of
+         * references (like `std::tie`) is expected.
+         */
+        template < size_type N, typename T >
+        constexpr auto as_tie(T &obj) noexcept
+        {
+            static_assert(std::is_aggregate< std::remove_cv_t< T > >::value, "bitpacker: only aggregate types can be bound to a format");
+            static_assert(N >= 1 && N <= max_tie_members, "bitpacker: aggregate has too many members to be bound to a format");
+            if constexpr (N == 1) { auto &[m0] = obj; return std::tie(m0); }
+            else if constexpr (N == 2) { auto &[m0, m1] = obj; return std::tie(m0, m1); }
+            else if constexpr (N == 3) { auto &[m0, m1, m2] = obj; return std::tie(m0, m1, m2); }
+            else if constexpr (N == 4) { auto &[m0, m1, m2, m3] = obj; return std::tie(m0, m1, m2, m3); }
+            else if constexpr (N == 5) { auto &[m0, m1, m2, m3, m4] = obj; return std::tie(m0, m1, m2, m3, m4); }
+            else if constexpr (N == 6) { auto &[m0, m1, m2, m3, m4, m5] = obj; return std::tie(m0, m1, m2, m3, m4, m5); }
+            else if constexpr (N == 7) { auto &[m0, m1, m2, m3, m4, m5, m6] = obj; return std::tie(m0, m1, m2, m3, m4, m5, m6); }
+            else if constexpr (N == 8) { auto &[m0, m1, m2, m3, m4, m5, m6, m7] = obj; return std::tie(m0, m1, m2, m3, m4, m5, m6, m7); }
+            else if constexpr (N == 9) { auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8] = obj; return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8); }
+            else if constexpr (N == 10) { auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9] = obj; return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9); }
+            else if constexpr (N == 11) { auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10] = obj; return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10); }
+            else if constexpr (N == 12) { auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11] = obj; return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11); }
+            else if constexpr (N == 13) { auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12] = obj; return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12); }
+            else if constexpr (N == 14) { auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13] = obj; return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13); }
+            else if constexpr (N == 15) { auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14] = obj; return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14); }
+            else if constexpr (N == 16) { auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15] = obj; return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15); }
+            else if constexpr (N == 17) { auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16] = obj; return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16); }
+            else if constexpr (N == 18) { auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17] = obj; return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17); }
+            else if constexpr (N == 19) { auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18] = obj; return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18); }
+            else if constexpr (N == 20) { auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18, m19] = obj; return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18, m19); }
+            else if constexpr (N == 21) { auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18, m19, m20] = obj; return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18, m19, m20); }
+            else if constexpr (N == 22) { auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18, m19, m20, m21] = obj; return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18, m19, m20, m21); }
+            else if constexpr (N == 23) { auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18, m19, m20, m21, m22] = obj; return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18, m19, m20, m21, m22); }
+            else if constexpr (N == 24) { auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18, m19, m20, m21, m22, m23] = obj; return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18, m19, m20, m21, m22, m23); }
+            else if constexpr (N == 25) { auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18, m19, m20, m21, m22, m23, m24] = obj; return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18, m19, m20, m21, m22, m23, m24); }
+            else if constexpr (N == 26) { auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18, m19, m20, m21, m22, m23, m24, m25] = obj; return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18, m19, m20, m21, m22, m23, m24, m25); }
+            else if constexpr (N == 27) { auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18, m19, m20, m21, m22, m23, m24, m25, m26] = obj; return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18, m19, m20, m21, m22, m23, m24, m25, m26); }
+            else if constexpr (N == 28) { auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18, m19, m20, m21, m22, m23, m24, m25, m26, m27] = obj; return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18, m19, m20, m21, m22, m23, m24, m25, m26, m27); }
+            else if constexpr (N == 29) { auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18, m19, m20, m21, m22, m23, m24, m25, m26, m27, m28] = obj; return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18, m19, m20, m21, m22, m23, m24, m25, m26, m27, m28); }
+            else if constexpr (N == 30) { auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18, m19, m20, m21, m22, m23, m24, m25, m26, m27, m28, m29] = obj; return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18, m19, m20, m21, m22, m23, m24, m25, m26, m27, m28, m29); }
+            else if constexpr (N == 31) { auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18, m19, m20, m21, m22, m23, m24, m25, m26, m27, m28, m29, m30] = obj; return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18, m19, m20, m21, m22, m23, m24, m25, m26, m27, m28, m29, m30); }
+            else if constexpr (N == 32) { auto &[m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18, m19, m20, m21, m22, m23, m24, m25, m26, m27, m28, m29, m30, m31] = obj; return std::tie(m0, m1, m2, m3, m4, m5, m6, m7, m8, m9, m10, m11, m12, m13, m14, m15, m16, m17, m18, m19, m20, m21, m22, m23, m24, m25, m26, m27, m28, m29, m30, m31); }
+        }
+
+        /// helper function to unpack each field directly into the matching output
+        template < typename Fmt, size_type... Items, typename... Outputs >
+        constexpr void unpack_into(std::index_sequence< Items... > /*unused*/, span< const byte_type > input, const size_type start_bit, Outputs &... outputs)
+        {
+            static_assert(sizeof...(Outputs) == sizeof...(Items), "unpack_into expected outputs != sizeof...(outputs) passed");
+            static_assert(!impl::has_counted_item(Fmt{}) || sizeof...(Items) < impl::count_non_padding(Fmt{}),
+                          "formats with a counted array item ('[#k]') can only be used with unpack_counted() and pack_counted_into()");
+            static_assert(!impl::has_optional_group(Fmt{}), "formats with an optional group ('{#k:...}') can only be used with unpack_optional() and pack_optional_into()");
+            constexpr auto byte_order = impl::layout< Fmt >::byte_order;
+            static_assert(byte_order == impl::Endian::big, "Unpacking little endian byte order not supported yet...");
+
+            using table = impl::item_table< Fmt >;
+            if constexpr (table::enabled && sizeof...(Items) == impl::count_non_padding(Fmt{})) {
+                std::array< uint64_t, table::value_count > values{};
+                impl::read_items(input, start_bit, table::ops.data(), table::value_count, values.data());
+                int _[] = { 0, impl::item_result< Fmt, Items >(values.data() + table::first_value[Items], outputs)... };
+                (void)_; // _ is a dummy for pack expansion
+            }
+            else {
+                constexpr const auto &formats = impl::layout< Fmt >::fields;
+                int _[] = { 0, impl::unpackElementInto< impl::field_type< Fmt, Items > >(input, formats[Items].offset + start_bit, outputs)... };
+                (void)_; // _ is a dummy for pack expansion
+            }
+        }
+
+        /// unpack into the members of the aggregate `out`
+        template < typename Fmt, size_type... Items, typename Aggregate >
+        constexpr void unpack_into_aggregate(std::index_sequence< Items... > seq, span< const byte_type > input, const size_type start_bit, Aggregate &out)
+        {
+            auto members = impl::as_tie< sizeof...(Items) >(out);
+            impl::unpack_into< Fmt >(seq, input, start_bit, std::get< Items >(members)...);
+        }
+
+        template < typename T >
+        struct is_std_array : std::false_type {};
+
+        template < typename T, std::size_t N >
+        struct is_std_array< std::array< T, N > > : std::true_type {};
+
+        /// aggregates that are unpacked member by member: structs, but not C arrays or `std::array` which hold one field
+        template < typename T >
+        constexpr bool is_member_aggregate = std::is_class< T >::value && std::is_aggregate< T >::value && !is_std_array< T >::value;
+
+        /// true if a single output `Output` should be treated as an aggregate with one member per field of Fmt
+        template < typename Fmt, typename... Outputs >
+        constexpr bool is_aggregate_output() noexcept
+        {
+            if constexpr (sizeof...(Outputs) != 1) {
+                return false;
+            }
+            else if constexpr (impl::count_non_padding(Fmt{}) == 1) {
+                // a single field format unpacks into a struct only if the field can't be assigned to it directly
+                using field_type = typename impl::field_info< Fmt, 0 >::type::return_type;
+                return !std::is_assignable< Outputs &..., field_type >::value && (is_member_aggregate< Outputs > && ...);
+            }
+            else {
+                return (is_member_aggregate< Outputs > && ...);
+            }
+        }
 
-        const auto unpacked = std::make_tuple(
-            impl::unpackElement< typename std::tuple_element_t< Items, FormatTypes > >(
-                // NOLINTNEXTLINE - this is the standard implementation of std::as_bytes() from c++20
-                {reinterpret_cast<const byte_type*>(std::data(packedInput)), std::size(packedInput)},
-                formats[Items].offset+start_bit)...);
-        return unpacked;
+    }  // namespace impl
+
+/***************************************************************************************************
+* Binding aggregates to formats
+***************************************************************************************************/
+
+    /**
+     * Specialize to bind the aggregate `T` to a format, with one non-padding field per member (in order).
+     * The specialization needs one static member function returning the format:
+     * @code
+     *     template <> struct bitpacker::format_binding<MessageData> {
+     *         static constexpr auto format() { return BP_STRING("u12b1b1u14s24"); }
+     *     };
+     * @endcode
+     * `bitpacker::get<T>` and `bitpacker::store<T>` then work for `T` without writing them by hand.
+     */
+    template < typename T >
+    struct format_binding;
+
+    namespace impl {
+
+        template < typename T, typename = void >
+        struct has_format_binding : std::false_type {};
+
+        template < typename T >
+        struct has_format_binding< T, std::void_t< decltype(format_binding< T >::format()) > > : std::true_type {};
+
+        template < typename T >
+        using binding_format_t = decltype(format_binding< T >::format());
+
+        /// helper function to pack each member of the aggregate `value`
+        template < typename Fmt, size_type... Items, typename Aggregate >
+        constexpr void pack_aggregate(span< byte_type > output, const size_type start_bit, std::index_sequence< Items... > seq, Aggregate &value)
+        {
+            const auto members = impl::as_tie< sizeof...(Items) >(value);
+            impl::pack< Fmt >(output, start_bit, seq, std::get< Items >(members)...);
+        }
+
+    }  // namespace impl
+
+    /**
+     * Default implementation of `get<T>` for aggregates bound to a format with `format_binding<T>`.
+     * Each member is decoded directly from the buffer, there is no intermediate tuple.
+     */
+    template < typename T >
+    constexpr T get(span< const byte_type > buffer, size_type offset) noexcept
+    {
+        static_assert(impl::has_format_binding< T >::value,
+                      "bitpacker::get<T> : no specialization of bitpacker::get<T> or bitpacker::format_binding<T> for this type");
+        using Fmt = impl::binding_format_t< T >;
+        static_assert(impl::count_non_padding(Fmt{}) <= impl::max_tie_members,
+                      "bitpacker::get<T> : format_binding<T> supports aggregates of at most 32 members, specialize bitpacker::get<T> for larger types");
+        T value{};
+        impl::unpack_into_aggregate< Fmt >(std::make_index_sequence< impl::count_non_padding(Fmt{}) >(), buffer, offset, value);
+        return value;
     }
 
     /**
-     * Pack Args... into an array of bytes according to given format string fmt.
-     * @param fmt [IN] format string created with macro `BP_STRING()`
-     * @param args... [IN] list of arguments to pack into the format string
-     * @return std::array of bytes holding the packed data
+     * Default implementation of `store<T>` for aggregates bound to a format with `format_binding<T>`.
+     * Each member is encoded directly into the buffer, along with the padding of the format.
      */
-    template < typename Fmt, typename... Args >
-    constexpr auto pack(Fmt /*unused*/, Args&&... args)
+    template < typename T >
+    constexpr void store(span< byte_type > buffer, size_type offset, T value) noexcept
     {
-        std::array<byte_type, calcbytes(Fmt{})> output{};
-        impl::pack< Fmt >(output, 0, std::make_index_sequence< impl::count_non_padding(Fmt{}) >(), std::forward< Args >(args)...);
-        return output;
+        static_assert(impl::has_format_binding< T >::value,
+                      "bitpacker::store<T> : no specialization of bitpacker::store<T> or bitpacker::format_binding<T> for this type");
+        using Fmt = impl::binding_format_t< T >;
+        static_assert(impl::count_non_padding(Fmt{}) <= impl::max_tie_members,
+                      "bitpacker::store<T> : format_binding<T> supports aggregates of at most 32 members, specialize bitpacker::store<T> for larger types");
+        impl::pack_aggregate< Fmt >(buffer, offset, std::make_index_sequence< impl::count_non_padding(Fmt{}) >(), value);
     }
 
     /**
-     * Pack Args... into data, starting at given bit offset offset, according to given format string fmt.
+     * Unpack packedInput (container of bytes) according to given format string fmt, starting at bit `offset`,
+     * writing each field directly into the matching output. No intermediate tuple is created, and 'r' and 't'
+     * fields are decoded straight into their destination.
      * @param fmt [IN] format string created with macro `BP_STRING()`
-     * @param data [IN/OUT] reference to existing std::array of bytes to pack into
+     * @param packedInput [IN] container of byte types
      * @param offset [IN] bit index to start unpacking from
-     * @param args... [IN] list of arguments to pack into the format string
+     * @param outputs... [OUT] one output per non-padding field, or a single aggregate with one member per non-padding field
+     */
+    template < typename Fmt, typename Input, typename... Outputs >
+    constexpr void unpack_from_into(Fmt /*unused*/, Input &&packedInput, const size_type offset, Outputs &... outputs)
+    {
+        // NOLINTNEXTLINE - this is the standard implementation of std::as_bytes() from c++20
+        const span< const byte_type > input{reinterpret_cast< const byte_type * >(std::data(packedInput)), std::size(packedInput)};
+        if constexpr (impl::is_aggregate_output< Fmt, Outputs... >()) {
+            static_assert(impl::count_non_padding(Fmt{}) <= impl::max_tie_members,
+                          "bitpacker::unpack_into : an aggregate output can have at most 32 members, pass one output per field for larger formats");
+            impl::unpack_into_aggregate< Fmt >(std::make_index_sequence< impl::count_non_padding(Fmt{}) >(), input, offset, outputs...);
+        }
+        else {
+            impl::unpack_into< Fmt >(std::make_index_sequence< impl::count_non_padding(Fmt{}) >(), input, offset, outputs...);
+        }
+    }
+
+    /**
+     * Unpack packedInput (container of bytes) according to given format string fmt, writing each field
+     * directly into the matching output. No intermediate tuple is created, and 'r' and 't' fields are decoded
+     * straight into their destination.
+     * @param fmt [IN] format string created with macro `BP_STRING()`
+     * @param packedInput [IN] container of byte types
+     * @param outputs... [OUT] one output per non-padding field, or a single aggregate with one member per non-padding field
+     */
+    template < typename Fmt, typename Input, typename... Outputs >
+    constexpr void unpack_into(Fmt /*unused*/, Input &&packedInput, Outputs &... outputs)
+    {
+        unpack_from_into(Fmt{}, std::forward< Input >(packedInput), 0, outputs...);
+    }
+
+    /**
+     * Pack Args... into an array of bytes according to given format string fmt.
+     * @param fmt [IN] format string created with macro `BP_STRING()`
+     * @param args... [IN] list of arguments to pack into the format string
+     * @return std::array of bytes holding the packed data
+     */
+    template < typename Fmt, typename... Args >
+    constexpr auto pack(Fmt /*unused*/, Args&&... args)
+    {
+        std::array<byte_type, calcbytes(Fmt{})> output{};
+        impl::pack< Fmt >(output, 0, std::make_index_sequence< impl::count_non_padding(Fmt{}) >(), std::forward< Args >(args)...);
+        return output;
+    }
+
+    /**
+     * Pack Args... into data, starting at given bit offset offset, according to given format string fmt.
+     * @param fmt [IN] format string created with macro `BP_STRING()`
+     * @param data [IN/OUT] reference to existing std::array of bytes to pack into
+     * @param offset [IN] bit index to start unpacking from
+     * @param args... [IN] list of arguments to pack into the format string
      */
     template < typename Fmt, size_type N, typename... Args >
     constexpr void pack_into(Fmt /*unused*/, std::array<byte_type, N>& data, const size_type offset, Args&&... args)
     {
-        static_assert(calcbytes(Fmt{}) <= N, "bitpacker::pack_into : format larger than given array, not even counting the offset!");
-        impl::pack< Fmt >(data, offset, std::make_index_sequence< impl::count_non_padding(Fmt{}) >(), std::forward< Args >(args)...);
+        static_assert(calcbytes(Fmt{}) <= N, "bitpacker::pack_into : format larger than given array, not even counting the offset!");
+        impl::pack< Fmt >(data, offset, std::make_index_sequence< impl::count_non_padding(Fmt{}) >(), std::forward< Args >(args)...);
+    }
+
+/***************************************************************************************************
+* Counted arrays
+***************************************************************************************************/
+
+    namespace impl {
+
+        /// true if the only counted array item of Fmt is its last item, and it is counted by an earlier unsigned field
+        template < typename Fmt >
+        constexpr bool valid_counted_format(Fmt /*unused*/) noexcept
+        {
+            const auto &types = impl::layout< Fmt >::types;
+            for (size_type i = 0; i + 1 < types.size(); ++i) {
+                if (types[i].counted || types[i].group != 0) {
+                    return false;
+                }
+            }
+            const auto &fields = impl::layout< Fmt >::fields;
+            const auto last = types.back();
+            const auto last_field = impl::count_non_padding(Fmt{}) - 1;
+            return last.counted && last.group == 0 && !isPadding(last.formatChar) && last.count_field < last_field
+                   && fields[last.count_field].formatChar == 'u' && fields[last.count_field].repeat == 0;
+        }
+
+        /// the counted array item of Fmt
+        template < typename Fmt >
+        struct counted_info {
+            static_assert(valid_counted_format(Fmt{}), "counted array item ('[#k]') must be the last item, and k must be an earlier unsigned field");
+            static constexpr const auto &formats = impl::layout< Fmt >::fields;
+            static constexpr size_type index = impl::count_non_padding(Fmt{}) - 1;
+            static constexpr auto item = formats[index];
+            static constexpr auto counter = formats[item.count_field];
+            using element = impl::FormatType< item.formatChar, item.count, item.endian >;
+            using count_type = impl::FormatType< counter.formatChar, counter.count, counter.endian >;
+        };
+
+        /// unpack `count` back to back values of the type Element starting at bit `offset`
+        template < typename Element, typename Output >
+        constexpr void unpack_uniform(span< const byte_type > input, size_type offset, const size_type count, Output &output)
+        {
+            for (size_type i = 0; i < count; ++i, offset += Element::bits) {
+                impl::unpackElementInto< Element >(input, offset, output[i]);
+            }
+        }
+
+        /// pack `count` values from `values` back to back as the type Element, starting at bit `offset`
+        template < typename Element, typename Values >
+        constexpr void pack_uniform(span< byte_type > output, size_type offset, const size_type count, const Values &values)
+        {
+            for (size_type i = 0; i < count; ++i, offset += Element::bits) {
+                impl::packElement< Element >(output, offset, values[i]);
+            }
+        }
+
+        /// unpack the fields Items... of Fmt into the matching elements of the tuple of references `outputs`
+        template < typename Fmt, size_type... Items, typename Outputs >
+        constexpr void unpack_into_fixed(std::index_sequence< Items... > seq, span< const byte_type > input, const size_type start_bit, Outputs outputs)
+        {
+            impl::unpack_into< Fmt >(seq, input, start_bit, std::get< Items >(outputs)...);
+        }
+
+        template < typename Fmt, size_type... Items, typename... Args >
+        constexpr bool pack_counted(std::index_sequence< Items... > seq, span< byte_type > output, const size_type start_bit, const Args &... args)
+        {
+            using info = counted_info< Fmt >;
+            const auto arg_refs = std::forward_as_tuple(args...);
+            // the largest count the count field can hold, so the packed count always matches the packed elements
+            constexpr uint64_t max_count = info::counter.count >= 64 ? ~uint64_t{0} : (uint64_t{1} << info::counter.count) - 1U;
+            const auto count = static_cast< size_type >(std::get< info::item.count_field >(arg_refs));
+            const auto &values = std::get< info::index >(arg_refs);
+            if (count > max_count || count > std::size(values) || output.size() * ByteSize < start_bit + calcsize(Fmt{}) + (count * info::element::bits)) {
+                return false;
+            }
+            impl::pack< Fmt >(output, start_bit, seq, std::get< Items >(arg_refs)...);
+            impl::pack_uniform< typename info::element >(output, start_bit + info::item.offset, count, values);
+            return true;
+        }
+
+    }  // namespace impl
+
+    /**
+     * The number of bits used by the format fmt when its counted array item (`[#k]`) holds `count` elements.
+     * @param fmt [IN] format string created with macro `BP_STRING()`
+     * @param count [IN] number of elements in the counted array
+     * @return number of bits
+     */
+    template < typename Fmt >
+    constexpr size_type packed_size(Fmt /*unused*/, const size_type count) noexcept
+    {
+        return calcsize(Fmt{}) + (count * impl::counted_info< Fmt >::element::bits);
+    }
+
+    /**
+     * Unpack a format that ends with a counted array item (`s14[#0]`) starting at bit `offset`. The fixed fields
+     * are written to the matching outputs, and the elements of the counted array to the last output, which
+     * can be any indexable container with `std::size()` (a span, array, vector...). Sizes are checked once,
+     * before anything is written.
+     * @param fmt [IN] format string created with macro `BP_STRING()`
+     * @param packedInput [IN] span of bytes to unpack
+     * @param offset [IN] bit index to start unpacking from
+     * @param outputs... [OUT] one output per non-padding field
+     * @return false (and nothing unpacked) if the input is too short or the last output is smaller than the count
+     */
+    template < typename Fmt, typename... Outputs >
+    constexpr bool unpack_counted_from(Fmt /*unused*/, span< const byte_type > packedInput, const size_type offset, Outputs &... outputs)
+    {
+        using info = impl::counted_info< Fmt >;
+        static_assert(sizeof...(Outputs) == info::index + 1, "bitpacker::unpack_counted : expected one output per non-padding field");
+        if (packedInput.size() * ByteSize < offset + calcsize(Fmt{})) {
+            return false;
+        }
+        const size_type count = impl::unpackElement< typename info::count_type >(packedInput, offset + info::counter.offset);
+        auto &values = std::get< info::index >(std::tie(outputs...));
+        if (count > std::size(values) || packedInput.size() * ByteSize < offset + packed_size(Fmt{}, count)) {
+            return false;
+        }
+        impl::unpack_into_fixed< Fmt >(std::make_index_sequence< info::index >(), packedInput, offset, std::tie(outputs...));
+        impl::unpack_uniform< typename info::element >(packedInput, offset + info::item.offset, count, values);
+        return true;
+    }
+
+    /**
+     * Unpack a format that ends with a counted array item (`s14[#0]`) from the start of packedInput.
+     * See `unpack_counted_from()`.
+     */
+    template < typename Fmt, typename... Outputs >
+    constexpr bool unpack_counted(Fmt /*unused*/, span< const byte_type > packedInput, Outputs &... outputs)
+    {
+        return unpack_counted_from(Fmt{}, packedInput, 0, outputs...);
+    }
+
+    /**
+     * Pack a format that ends with a counted array item (`s14[#0]`), starting at bit `offset`. The count field
+     * is packed like any other field, and that many elements are packed from the last argument.
+     * @param fmt [IN] format string created with macro `BP_STRING()`
+     * @param output [OUT] span of bytes to pack into
+     * @param offset [IN] bit index to start packing at
+     * @param args... [IN] one value per non-padding field, the last one an indexable container of elements
+     * @return false (and nothing packed) if the output is too short or the last argument has fewer elements than the count
+     */
+    template < typename Fmt, typename... Args >
+    constexpr bool pack_counted_into(Fmt /*unused*/, span< byte_type > output, const size_type offset, const Args &... args)
+    {
+        static_assert(sizeof...(Args) == impl::counted_info< Fmt >::index + 1, "bitpacker::pack_counted_into : expected one argument per non-padding field");
+        return impl::pack_counted< Fmt >(std::make_index_sequence< impl::counted_info< Fmt >::index >(), output, offset, args...);
+    }
+
+/***************************************************************************************************
+* Optional groups
+***************************************************************************************************/
+
+    namespace impl {
+
+        /// number of optional groups in the format
+        template < typename Fmt >
+        constexpr size_type count_groups(Fmt /*unused*/) noexcept
+        {
+            size_type count = 0;
+            for (const auto &t : impl::layout< Fmt >::types) {
+                count = t.group > count ? t.group : count;
+            }
+            return count;
+        }
+
+        /// description of one optional group, with offsets as if every group is present
+        struct OptionalGroup {
+            size_type begin;  //< offset of the first bit of the group
+            size_type bits;   //< number of bits in the group
+            size_type gate;   //< index of the non-padding 'b' field that says if the group is present
+        };
+
+        template < typename Fmt >
+        constexpr auto get_group_array(Fmt /*unused*/) noexcept
+        {
+            std::array< OptionalGroup, count_groups(Fmt{}) > groups{};
+            for (const auto &t : impl::layout< Fmt >::types) {
+                if (t.group != 0) {
+                    auto &g = groups[t.group - 1];
+                    if (g.bits == 0) {
+                        g.begin = t.offset;
+                        g.gate = t.gate_field;
+                    }
+                    g.bits = t.offset + t.count - g.begin;
+                }
+            }
+            return groups;
+        }
+
+        /// the number of groups that end at or before the item `t`. Only these groups move `t` when absent.
+        template < size_type N >
+        constexpr size_type groups_before(const std::array< OptionalGroup, N > &groups, const RawFormatType &t) noexcept
+        {
+            if (t.group != 0) {
+                return t.group - 1;
+            }
+            size_type count = 0;
+            for (const auto &g : groups) {
+                count += (g.begin + g.bits <= t.offset) ? 1 : 0;
+            }
+            return count;
+        }
+
+        /// true if each group is gated by an earlier, always present, 'b' field and no group is empty
+        template < typename Fmt >
+        constexpr bool valid_optional_format(Fmt /*unused*/) noexcept
+        {
+            const auto &fields = impl::layout< Fmt >::fields;
+            const auto field_count = impl::count_non_padding(Fmt{});
+            for (const auto &g : impl::get_group_array(Fmt{})) {
+                if (g.bits == 0 || g.gate >= field_count) {
+                    return false;
+                }
+                const auto &gate = fields[g.gate];
+                if (gate.formatChar != 'b' || gate.repeat != 0 || gate.group != 0 || gate.offset >= g.begin) {
+                    return false;
+                }
+            }
+            return !impl::has_counted_item(Fmt{});
+        }
+
+        /// the runtime part of an optional layout: which groups are present, and the bits removed before each group
+        template < size_type N >
+        struct optional_state {
+            std::array< bool, N > present{};
+            std::array< size_type, N + 1 > removed{};  //< removed[g] is the number of bits missing before group g
+
+            /// offset of `t` given the groups that are present
+            template < size_type M >
+            constexpr size_type offset_of(const std::array< OptionalGroup, M > &groups, const RawFormatType &t) const noexcept
+            {
+                return t.offset - removed[impl::groups_before(groups, t)];
+            }
+        };
+
+        template < typename Fmt >
+        struct optional_layout {
+            static_assert(valid_optional_format(Fmt{}), "each optional group ('{#k:...}') must hold at least one item and be gated by an earlier 'b' field that is not in a group");
+            static constexpr const auto &types = impl::layout< Fmt >::types;
+            static constexpr const auto &fields = impl::layout< Fmt >::fields;
+            static constexpr const auto &padding = impl::layout< Fmt >::padding;
+            static constexpr auto groups = impl::get_group_array(Fmt{});
+            static constexpr size_type group_count = impl::count_groups(Fmt{});
+            using state_type = optional_state< group_count >;
+
+            /// a small prefix sum over the groups, given a function that returns the value of non-padding field `gate`
+            template < typename GateFn >
+            static constexpr state_type make_state(GateFn &&gate_value)
+            {
+                state_type state{};
+                for (size_type g = 0; g < group_count; ++g) {
+                    state.present[g] = gate_value(g);
+                    state.removed[g + 1] = state.removed[g] + (state.present[g] ? 0 : groups[g].bits);
+                }
+                return state;
+            }
+
+            /// read every gate from `input`. Gates only move with groups before them, so they are read in order.
+            /// A gate past the end of input is read as false, the frame is then too long for input anyway.
+            static constexpr state_type read_state(span< const byte_type > input, const size_type start_bit)
+            {
+                state_type state{};
+                for (size_type g = 0; g < group_count; ++g) {
+                    const auto &gate = fields[groups[g].gate];
+                    const auto offset = start_bit + state.offset_of(groups, gate);
+                    state.present[g] = offset + gate.count <= input.size() * ByteSize
+                                       && extract< unsigned_type< 64 > >(input, offset, gate.count) != 0;
+                    state.removed[g + 1] = state.removed[g] + (state.present[g] ? 0 : groups[g].bits);
+                }
+                return state;
+            }
+        };
+
+        /// unpack non-padding field Index of a format with optional groups
+        template < typename Fmt, size_type Index >
+        constexpr auto unpack_optional_field(span< const byte_type > input, const size_type start_bit,
+                                             const typename optional_layout< Fmt >::state_type &state)
+        {
+            using layout = optional_layout< Fmt >;
+            constexpr auto field = layout::fields[Index];
+            using T = impl::FormatType< field.formatChar, impl::element_bits(field), field.endian, field.repeat >;
+            if constexpr (field.group != 0) {
+                using R = std::optional< typename T::return_type >;
+                if (!state.present[field.group - 1]) {
+                    return R{};
+                }
+                return R(impl::unpackElement< T >(input, start_bit + state.offset_of(layout::groups, field)));
+            }
+            else if constexpr (impl::groups_before(layout::groups, field) == 0) {
+                // fields before the first group keep their compile time offset
+                return impl::unpackElement< T >(input, start_bit + field.offset);
+            }
+            else {
+                return impl::unpackElement< T >(input, start_bit + state.offset_of(layout::groups, field));
+            }
+        }
+
+        template < typename Fmt, size_type... Items >
+        constexpr auto unpack_optional(std::index_sequence< Items... > /*unused*/, span< const byte_type > input, const size_type start_bit)
+        {
+            using layout = optional_layout< Fmt >;
+            const auto state = layout::read_state(input, start_bit);
+            using result_type = std::optional< std::tuple< decltype(impl::unpack_optional_field< Fmt, Items >(input, start_bit, state))... > >;
+            if (input.size() * ByteSize < start_bit + calcsize(Fmt{}) - state.removed[layout::group_count]) {
+                return result_type{};
+            }
+            return result_type(std::in_place, impl::unpack_optional_field< Fmt, Items >(input, start_bit, state)...);
+        }
+
+        /// the value to pack for a field given as `v`, which is empty optionals packed as zero
+        template < typename T >
+        constexpr const T &packed_value(const T &v) noexcept
+        {
+            return v;
+        }
+
+        template < typename T >
+        constexpr T packed_value(const std::optional< T > &v) noexcept
+        {
+            return v.has_value() ? *v : T{};
+        }
+
+        template < typename Fmt, size_type Index, typename Arg >
+        constexpr int pack_optional_field(span< byte_type > output, const size_type start_bit,
+                                          const typename optional_layout< Fmt >::state_type &state, const Arg &arg)
+        {
+            using layout = optional_layout< Fmt >;
+            constexpr auto field = layout::fields[Index];
+            using T = impl::FormatType< field.formatChar, impl::element_bits(field), field.endian, field.repeat >;
+            if (field.group == 0 || state.present[field.group - 1]) {
+                impl::packElement< T >(output, start_bit + state.offset_of(layout::groups, field), impl::packed_value(arg));
+            }
+            return 0;
+        }
+
+        template < typename Fmt, size_type Index >
+        constexpr int pack_optional_padding(span< byte_type > output, const size_type start_bit,
+                                            const typename optional_layout< Fmt >::state_type &state)
+        {
+            using layout = optional_layout< Fmt >;
+            constexpr auto pad = layout::padding[Index];
+            using T = impl::FormatType< pad.formatChar, impl::element_bits(pad), pad.endian, pad.repeat >;
+            if (pad.group == 0 || state.present[pad.group - 1]) {
+                impl::packElement< T >(output, start_bit + state.offset_of(layout::groups, pad), 0);
+            }
+            return 0;
+        }
+
+        template < typename Fmt, size_type... Items, size_type... Pads, size_type... Groups, typename... Args >
+        constexpr size_type pack_optional(std::index_sequence< Items... > /*unused*/, std::index_sequence< Pads... > /*unused*/,
+                                          std::index_sequence< Groups... > /*unused*/, span< byte_type > output, const size_type start_bit,
+                                          const Args &... args)
+        {
+            using layout = optional_layout< Fmt >;
+            const auto arg_refs = std::forward_as_tuple(args...);
+            const bool gates[] = { false, static_cast< bool >(std::get< layout::groups[Groups].gate >(arg_refs))... };
+            const auto state = layout::make_state([&](const size_type g) { return gates[g + 1]; });
+            const size_type bits = calcsize(Fmt{}) - state.removed[layout::group_count];
+            if (output.size() * ByteSize < start_bit + bits) {
+                return 0;
+            }
+            int _[] = { 0, impl::pack_optional_padding< Fmt, Pads >(output, start_bit, state)...,
+                        impl::pack_optional_field< Fmt, Items >(output, start_bit, state, args)... };
+            (void)_; // _ is a dummy for pack expansion
+            return bits;
+        }
+
+    }  // namespace impl
+
+    /**
+     * Unpack a format with optional groups (`{#k:...}`) starting at bit `offset`. Fields in a group unpack to
+     * a `std::optional`, which is empty when the group's gate field is false and the group is not in the input.
+     * Fields before the first group have fixed offsets; the offsets of later fields come from a prefix sum over
+     * the groups that are missing. The length of the frame is checked once, after the gates are read and before
+     * any other field is decoded.
+     * @param fmt [IN] format string created with macro `BP_STRING()`
+     * @param packedInput [IN] span of bytes to unpack
+     * @param offset [IN] bit index to start unpacking from
+     * @return `std::optional` of the tuple of results according to format string, empty if packedInput is too short
+     */
+    template < typename Fmt >
+    constexpr auto unpack_optional_from(Fmt /*unused*/, span< const byte_type > packedInput, const size_type offset)
+    {
+        return impl::unpack_optional< Fmt >(std::make_index_sequence< impl::count_non_padding(Fmt{}) >(), packedInput, offset);
+    }
+
+    /**
+     * Unpack a format with optional groups (`{#k:...}`) from the start of packedInput. See `unpack_optional_from()`.
+     * @param fmt [IN] format string created with macro `BP_STRING()`
+     * @param packedInput [IN] span of bytes to unpack
+     * @return `std::optional` of the tuple of results according to format string, empty if packedInput is too short
+     */
+    template < typename Fmt >
+    constexpr auto unpack_optional(Fmt /*unused*/, span< const byte_type > packedInput)
+    {
+        return unpack_optional_from(Fmt{}, packedInput, 0);
+    }
+
+    /**
+     * Pack a format with optional groups (`{#k:...}`) starting at bit `offset`. A group is packed only if the
+     * value given for its gate field is true. Fields in a group may be given as plain values or `std::optional`,
+     * an empty optional in a present group packs as zero.
+     * @param fmt [IN] format string created with macro `BP_STRING()`
+     * @param output [OUT] span of bytes to pack into. Must hold the packed size, at most `calcsize(fmt)` bits.
+     * @param offset [IN] bit index to start packing at
+     * @param args... [IN] one value per non-padding field, including the fields of missing groups
+     * @return number of bits written, or 0 (nothing written) if output is too small
+     */
+    template < typename Fmt, typename... Args >
+    constexpr size_type pack_optional_into(Fmt /*unused*/, span< byte_type > output, const size_type offset, const Args &... args)
+    {
+        static_assert(sizeof...(Args) == impl::count_non_padding(Fmt{}), "bitpacker::pack_optional_into : expected one argument per non-padding field");
+        return impl::pack_optional< Fmt >(std::make_index_sequence< impl::count_non_padding(Fmt{}) >(),
+                                          std::make_index_sequence< impl::count_padding(Fmt{}) >(),
+                                          std::make_index_sequence< impl::count_groups(Fmt{}) >(), output, offset, args...);
+    }
+
+/***************************************************************************************************
+* Batch (multi-record) interface
+***************************************************************************************************/
+
+    /// the tuple type returned by `unpack()` for the format Fmt
+    template < typename Fmt >
+    using unpack_result_t = decltype(unpack(std::declval< Fmt >(), std::declval< span< const byte_type > >()));
+
+    namespace impl {
+
+        /// greatest common divisor, std::gcd without pulling in <numeric>
+        constexpr size_type gcd(size_type a, size_type b) noexcept
+        {
+            while (b != 0) {
+                const auto t = a % b;
+                a = b;
+                b = t;
+            }
+            return a;
+        }
+
+        /**
+         * The smallest number of records of size `record_bits` that is a multiple of `boundary_bits` long.
+         * Splitting a stream of back-to-back records at multiples of this count keeps every split on a
+         * `boundary_bits` boundary, so no byte is shared between the pieces. ( lcm(record, boundary) / record )
+         */
+        constexpr size_type aligned_record_step(const size_type record_bits, const size_type boundary_bits) noexcept
+        {
+            return boundary_bits / impl::gcd(record_bits, boundary_bits);
+        }
+
+        /// helper function to unpack records [first, last) into an indexable container of tuples
+        template < typename Fmt, typename Output >
+        constexpr void unpack_records(span< const byte_type > input, const size_type first, const size_type last, Output &output)
+        {
+            constexpr auto record_bits = calcsize(Fmt{});
+            for (size_type r = first; r < last; ++r) {
+                output[r] = impl::unpack< Fmt >(std::make_index_sequence< impl::count_non_padding(Fmt{}) >(), input, r * record_bits);
+            }
+        }
+
+        /// unpack records [first, last) of a single field into a column
+        template < typename UnpackedType, typename Column >
+        constexpr int unpack_column(span< const byte_type > input, const size_type field_offset, const size_type stride,
+                                    const size_type first, const size_type last, Column &column)
+        {
+            for (size_type r = first; r < last; ++r) {
+                column[r] = impl::unpackElement< UnpackedType >(input, (r * stride) + field_offset);
+            }
+            return 0;
+        }
+
+        /// helper function to unpack records [first, last) into per-field columns
+        template < typename Fmt, size_type... Items, typename... Columns >
+        constexpr void unpack_columns(span< const byte_type > input, const size_type first, const size_type last,
+                                      std::index_sequence< Items... > /*unused*/, Columns &... columns)
+        {
+            static_assert(sizeof...(Columns) == sizeof...(Items), "unpack_columns expected columns != sizeof...(columns) passed");
+            constexpr auto byte_order = impl::layout< Fmt >::byte_order;
+            static_assert(byte_order == impl::Endian::big, "Unpacking little endian byte order not supported yet...");
+            constexpr auto record_bits = calcsize(Fmt{});
+            constexpr const auto &formats = impl::layout< Fmt >::fields;
+
+            int _[] = { 0, impl::unpack_column< impl::field_type< Fmt, Items > >(input, formats[Items].offset, record_bits,
+                                                                                 first, last, columns)... };
+            (void)_; // _ is a dummy for pack expansion
+        }
+
+        /// helper function to pack a tuple (or tuple like type) of values at bit `offset`
+        template < typename Fmt, typename Record, size_type... Items >
+        constexpr void pack_record(span< byte_type > output, const size_type offset, const Record &record, std::index_sequence< Items... > seq)
+        {
+            impl::pack< Fmt >(output, offset, seq, std::get< Items >(record)...);
+        }
+
+        /// helper function to pack records [first, last) from an indexable container of tuples
+        template < typename Fmt, typename Records >
+        constexpr void pack_records(span< byte_type > output, const size_type first, const size_type last, const Records &records)
+        {
+            constexpr auto record_bits = calcsize(Fmt{});
+            for (size_type r = first; r < last; ++r) {
+                impl::pack_record< Fmt >(output, r * record_bits, records[r], std::make_index_sequence< impl::count_non_padding(Fmt{}) >());
+            }
+        }
+
+        /// image of a single record of format Fmt with only the padding fields set
+        template < typename Fmt >
+        constexpr auto padding_image()
+        {
+            std::array< byte_type, calcbytes(Fmt{}) > image{};
+            impl::insert_padding< Fmt >(image, 0, std::make_index_sequence< impl::count_padding(Fmt{}) >());
+            return image;
+        }
+
+        /// set the padding of records [first, last) in a stream of back-to-back records of format Fmt
+        template < typename Fmt >
+        constexpr void fill_padding(span< byte_type > output, const size_type first, const size_type last)
+        {
+            constexpr auto record_bits = calcsize(Fmt{});
+            if constexpr (impl::count_padding(Fmt{}) > 0) {
+                if constexpr (impl::is_aligned(record_bits)) {
+                    // every record starts on a byte, so the same constant image can be copied into each one
+                    constexpr auto image = impl::padding_image< Fmt >();
+                    for (size_type r = first; r < last; ++r) {
+                        impl::copy(image.begin(), image.end(), output.begin() + (r * record_bits) / ByteSize);
+                    }
+                }
+                else {
+                    for (size_type r = first; r < last; ++r) {
+                        impl::insert_padding< Fmt >(output, r * record_bits, std::make_index_sequence< impl::count_padding(Fmt{}) >());
+                    }
+                }
+            }
+        }
+
+        /// pack records [first, last) of a single column into the field at `field_offset` of each record
+        template < typename PackedType, typename Column >
+        constexpr int pack_column(span< byte_type > output, const size_type field_offset, const size_type stride,
+                                  const size_type first, const size_type last, const Column &column)
+        {
+            for (size_type r = first; r < last; ++r) {
+                impl::packElement< PackedType >(output, (r * stride) + field_offset, column[r]);
+            }
+            return 0;
+        }
+
+        /// helper function to pack records [first, last) from per-field columns
+        template < typename Fmt, size_type... Items, typename... Columns >
+        constexpr void pack_columns(span< byte_type > output, const size_type first, const size_type last,
+                                    std::index_sequence< Items... > /*unused*/, const Columns &... columns)
+        {
+            static_assert(sizeof...(Columns) == sizeof...(Items), "pack_columns expected columns != sizeof...(columns) passed");
+            constexpr auto byte_order = impl::layout< Fmt >::byte_order;
+            static_assert(byte_order == impl::Endian::big, "Packing little endian byte order not supported yet...");
+            constexpr auto record_bits = calcsize(Fmt{});
+            constexpr const auto &formats_no_pad = impl::layout< Fmt >::fields;
+
+            impl::fill_padding< Fmt >(output, first, last);
+            // field-major: each column is scattered into the stream with a constant stride
+            int _[] = { 0, impl::pack_column< impl::field_type< Fmt, Items > >(output, formats_no_pad[Items].offset, record_bits,
+                                                                               first, last, columns)... };
+            (void)_; // _ is a dummy for pack expansion
+        }
+
+    }   // namespace impl
+
+    namespace impl {
+
+        template < typename T, typename = void >
+        struct has_size : std::false_type {};
+
+        template < typename T >
+        struct has_size< T, std::void_t< decltype(std::size(std::declval< const T & >())) > > : std::true_type {};
+
+        /// true if `container` has at least `count` elements. Containers without `std::size()` (pointers) can't be checked.
+        template < typename Container >
+        constexpr bool holds(const Container &container, const size_type count) noexcept
+        {
+            if constexpr (has_size< Container >::value) {
+                return static_cast< size_type >(std::size(container)) >= count;
+            }
+            else {
+                return true;
+            }
+        }
+
+        /// true if `count` back-to-back records of format Fmt fit in `bytes` bytes
+        template < typename Fmt >
+        constexpr bool batch_fits(const size_type bytes, const size_type count) noexcept
+        {
+            return count <= (bytes * ByteSize) / calcsize(Fmt{});
+        }
+
+    }  // namespace impl
+
+    /**
+     * Pack `count` records of format fmt back-to-back into output, taking field values from per-field columns.
+     * Record `r` starts at bit `r * calcsize(fmt)`. Equivalent to calling `pack_into` for each record, but the
+     * padding is written from one constant image and each column is written with a constant stride.
+     * @param fmt [IN] format string created with macro `BP_STRING()`
+     * @param output [OUT] span of bytes to pack into. Must hold at least `count * calcsize(fmt)` bits.
+     * @param count [IN] number of records to pack
+     * @param columns... [IN] one indexable container per non-padding field, each holding at least `count` values
+     * @return false, with nothing written, if output or a column is too small for `count` records
+     */
+    template < typename Fmt, typename... Columns >
+    constexpr bool pack_columns(Fmt /*unused*/, span< byte_type > output, const size_type count, const Columns &... columns)
+    {
+        if (!impl::batch_fits< Fmt >(output.size(), count) || !(impl::holds(columns, count) && ...)) {
+            return false;
+        }
+        impl::pack_columns< Fmt >(output, 0, count, std::make_index_sequence< impl::count_non_padding(Fmt{}) >(), columns...);
+        return true;
+    }
+
+    /**
+     * Pack `count` records of format fmt back-to-back into output from an indexable container of tuples.
+     * Record `r` starts at bit `r * calcsize(fmt)`. Bits after the last record are not modified.
+     * @param fmt [IN] format string created with macro `BP_STRING()`
+     * @param output [OUT] span of bytes to pack into. Must hold at least `count * calcsize(fmt)` bits.
+     * @param count [IN] number of records to pack
+     * @param records [IN] indexable container of tuples with one value per non-padding field, at least `count` long
+     * @return false, with nothing written, if output or records is too small for `count` records
+     */
+    template < typename Fmt, typename Records >
+    constexpr bool pack_batch(Fmt /*unused*/, span< byte_type > output, const size_type count, const Records &records)
+    {
+        if (!impl::batch_fits< Fmt >(output.size(), count) || !impl::holds(records, count)) {
+            return false;
+        }
+        impl::pack_records< Fmt >(output, 0, count, records);
+        return true;
+    }
+
+    /**
+     * Unpack `count` back-to-back records of format fmt from input into an indexable container of tuples.
+     * Record `r` starts at bit `r * calcsize(fmt)`.
+     * @param fmt [IN] format string created with macro `BP_STRING()`
+     * @param input [IN] span of bytes holding at least `count * calcsize(fmt)` bits
+     * @param count [IN] number of records to unpack
+     * @param output [OUT] indexable container of `unpack_result_t<Fmt>` with room for at least `count` items
+     * @return false, with nothing written, if input or output is too small for `count` records
+     */
+    template < typename Fmt, typename Output >
+    constexpr bool unpack_batch(Fmt /*unused*/, span< const byte_type > input, const size_type count, Output &&output)
+    {
+        if (!impl::batch_fits< Fmt >(input.size(), count) || !impl::holds(output, count)) {
+            return false;
+        }
+        impl::unpack_records< Fmt >(input, 0, count, output);
+        return true;
+    }
+
+    /**
+     * Unpack `count` back-to-back records of format fmt from input into per-field columns.
+     * Record `r` starts at bit `r * calcsize(fmt)`.
+     * @param fmt [IN] format string created with macro `BP_STRING()`
+     * @param input [IN] span of bytes holding at least `count * calcsize(fmt)` bits
+     * @param count [IN] number of records to unpack
+     * @param columns... [OUT] one indexable container per non-padding field, each with room for at least `count` values
+     * @return false, with nothing written, if input or a column is too small for `count` records
+     */
+    template < typename Fmt, typename... Columns >
+    constexpr bool unpack_columns(Fmt /*unused*/, span< const byte_type > input, const size_type count, Columns &&... columns)
+    {
+        if (!impl::batch_fits< Fmt >(input.size(), count) || !(impl::holds(columns, count) && ...)) {
+            return false;
+        }
+        impl::unpack_columns< Fmt >(input, 0, count, std::make_index_sequence< impl::count_non_padding(Fmt{}) >(), columns...);
+        return true;
+    }
+
+/***************************************************************************************************
+* Per-field view
+***************************************************************************************************/
+
+    /**
+     * Read only proxy for non-padding field `I` of a record in a byte buffer. The field is decoded each time the
+     * proxy is converted to `value_type` (or `get()` is called), never when the proxy is created.
+     * Like `std::vector<bool>::reference` it refers to the buffer, which must outlive it.
+     */
+    template < typename Fmt, size_type I >
+    class const_field_ref {
+    public:
+        using value_type = typename impl::field_type< Fmt, I >::return_type;
+
+        constexpr const_field_ref(span< const byte_type > buffer, size_type offset) noexcept :
+            m_buffer(buffer), m_offset(offset) {}
+
+        /// decode the field
+        constexpr value_type get() const
+        {
+            static_cast< void >(impl::field_info< Fmt, I >::offset);  // checks that field I has a fixed layout
+            return impl::unpack_field< Fmt, I >(m_buffer, m_offset);
+        }
+        constexpr operator value_type() const { return get(); }  // NOLINT - implicit so the proxy reads like the value
+
+        friend constexpr bool operator==(const const_field_ref &lhs, const const_field_ref &rhs) { return lhs.get() == rhs.get(); }
+        template < typename T >
+        friend constexpr bool operator==(const const_field_ref &lhs, const T &rhs) { return lhs.get() == rhs; }
+        template < typename T >
+        friend constexpr bool operator==(const T &lhs, const const_field_ref &rhs) { return lhs == rhs.get(); }
+        friend constexpr bool operator!=(const const_field_ref &lhs, const const_field_ref &rhs) { return !(lhs == rhs); }
+        template < typename T >
+        friend constexpr bool operator!=(const const_field_ref &lhs, const T &rhs) { return !(lhs == rhs); }
+        template < typename T >
+        friend constexpr bool operator!=(const T &lhs, const const_field_ref &rhs) { return !(lhs == rhs); }
+
+    private:
+        span< const byte_type > m_buffer;
+        size_type m_offset;
+    };
+
+    /**
+     * View of a single record of format Fmt in a byte buffer. `get<I>()` returns a `const_field_ref` that decodes
+     * field `I` when it is read, using the offset and width known at compile time, so fields that are never read
+     * are never decoded. Structured bindings are lazy too: each binding is a `const_field_ref`, so
+     * `auto [type, rest...] = view;` only decodes the bindings that are read.
+     */
+    template < typename Fmt >
+    class format_view {
+    public:
+        static constexpr size_type field_count = impl::count_non_padding(Fmt{});
+
+        constexpr format_view() noexcept = default;
+        /**
+         * @param buffer [IN] bytes holding the record
+         * @param offset [IN] bit offset of the record in buffer
+         */
+        constexpr explicit format_view(span< const byte_type > buffer, size_type offset = 0) noexcept :
+            m_buffer(buffer), m_offset(offset) {}
+
+        /// proxy that decodes non-padding field `I` (same index as in the tuple returned by `unpack()`) when read
+        template < size_type I >
+        constexpr const_field_ref< Fmt, I > get() const noexcept
+        {
+            static_assert(I < field_count, "bitpacker::format_view::get<I> : no such field");
+            return {m_buffer, m_offset};
+        }
+
+        /**
+         * Zero-copy view of the byte aligned raw or text field `I`, pointing into the viewed buffer.
+         * The format must place the field on a byte boundary with a multiple of 8 bits and MSB first bit order.
+         * The view must start on a byte boundary (`offset() % 8 == 0`), otherwise the result is an empty span.
+         */
+        template < size_type I >
+        constexpr span< const byte_type > bytes() const noexcept
+        {
+            static_assert(impl::field_info< Fmt, I >::is_byte_view, "bitpacker::format_view::bytes<I> : field must be a byte aligned, MSB first, 'r' or 't' field");
+            return impl::field_bytes< Fmt, I >(m_buffer, m_offset);
+        }
+
+        /// Zero-copy view of the byte aligned text field `I` as a string_view. Same requirements as `bytes<I>()`.
+        template < size_type I >
+        std::string_view text() const noexcept
+        {
+            const auto b = bytes< I >();
+            // NOLINTNEXTLINE - viewing bytes as characters
+            return {reinterpret_cast< const char * >(b.data()), b.size()};
+        }
+
+        constexpr span< const byte_type > buffer() const noexcept { return m_buffer; }
+        constexpr size_type offset() const noexcept { return m_offset; }
+
+    private:
+        span< const byte_type > m_buffer{};
+        size_type m_offset = 0;
+    };
+
+    /**
+     * Create a view of a single record of format fmt in packedInput. Fields are decoded one at a time with `get<I>()`.
+     * @param fmt [IN] format string created with macro `BP_STRING()`
+     * @param packedInput [IN] span of bytes holding the record
+     * @param offset [IN] bit offset of the record in packedInput
+     * @return `format_view<Fmt>` of the record
+     */
+    template < typename Fmt >
+    constexpr format_view< Fmt > view(Fmt /*unused*/, span< const byte_type > packedInput, const size_type offset = 0) noexcept
+    {
+        return format_view< Fmt >(packedInput, offset);
+    }
+
+    /// proxy that decodes non-padding field `I` of the record `v` views when read
+    template < size_type I, typename Fmt >
+    constexpr const_field_ref< Fmt, I > get(const format_view< Fmt > &v) noexcept
+    {
+        return v.template get< I >();
+    }
+
+    /// proxy for non-padding field `I` of a record in a mutable buffer. Reads and writes only touch that field.
+    template < typename Fmt, size_type I >
+    class field_ref {
+        using field = impl::field_info< Fmt, I >;
+
+    public:
+        using value_type = typename field::type::return_type;
+
+        constexpr field_ref(span< byte_type > buffer, size_type offset) noexcept :
+            m_buffer(buffer), m_offset(offset) {}
+        constexpr field_ref(const field_ref &) noexcept = default;
+
+        /// decode the field
+        constexpr value_type get() const { return impl::unpackElement< typename field::type >(m_buffer, m_offset + field::offset); }
+        constexpr operator value_type() const { return get(); }
+
+        /// encode `value` into the field. Bits outside the field are not modified.
+        template < typename T >
+        constexpr field_ref &operator=(const T &value)
+        {
+            impl::packElement< typename field::type >(m_buffer, m_offset + field::offset, value);
+            return *this;
+        }
+        constexpr field_ref &operator=(const field_ref &other) { return *this = other.get(); }
+
+    private:
+        span< byte_type > m_buffer;
+        size_type m_offset;
+    };
+
+    /**
+     * Mutable view of a single record of format Fmt in a byte buffer. `set<I>(value)` and `field<I>() = value`
+     * encode one field in place, touching only the bytes that hold that field. Padding and the other fields are
+     * left as they are in the buffer.
+     */
+    template < typename Fmt >
+    class mutable_format_view {
+    public:
+        static constexpr size_type field_count = impl::count_non_padding(Fmt{});
+
+        /**
+         * @param buffer [IN/OUT] bytes holding the record
+         * @param offset [IN] bit offset of the record in buffer
+         */
+        constexpr explicit mutable_format_view(span< byte_type > buffer, size_type offset = 0) noexcept :
+            m_buffer(buffer), m_offset(offset) {}
+
+        /// decode non-padding field `I` (same index as in the tuple returned by `unpack()`)
+        template < size_type I >
+        constexpr auto get() const { return field< I >().get(); }
+
+        /// encode `value` into non-padding field `I`. Bits outside the field are not modified.
+        template < size_type I, typename T >
+        constexpr void set(const T &value) { field< I >() = value; }
+
+        /// proxy to non-padding field `I` that can be read from and assigned to
+        template < size_type I >
+        constexpr field_ref< Fmt, I > field() const noexcept { return {m_buffer, m_offset}; }
+
+        /// Zero-copy mutable view of the byte aligned raw or text field `I`. Same requirements as `format_view::bytes<I>()`.
+        template < size_type I >
+        constexpr span< byte_type > bytes() const noexcept
+        {
+            static_assert(impl::field_info< Fmt, I >::is_byte_view, "bitpacker::mutable_format_view::bytes<I> : field must be a byte aligned, MSB first, 'r' or 't' field");
+            return impl::field_bytes< Fmt, I >(m_buffer, m_offset);
+        }
+
+        constexpr operator format_view< Fmt >() const noexcept { return format_view< Fmt >(m_buffer, m_offset); }
+        constexpr span< byte_type > buffer() const noexcept { return m_buffer; }
+        constexpr size_type offset() const noexcept { return m_offset; }
+
+    private:
+        span< byte_type > m_buffer;
+        size_type m_offset;
+    };
+
+    /**
+     * Create a mutable view of a single record of format fmt in data, to modify fields in place.
+     * @param fmt [IN] format string created with macro `BP_STRING()`
+     * @param data [IN/OUT] span of bytes holding the record
+     * @param offset [IN] bit offset of the record in data
+     * @return `mutable_format_view<Fmt>` of the record
+     */
+    template < typename Fmt >
+    constexpr mutable_format_view< Fmt > mutable_view(Fmt /*unused*/, span< byte_type > data, const size_type offset = 0) noexcept
+    {
+        return mutable_format_view< Fmt >(data, offset);
+    }
+
+/***************************************************************************************************
+* Record range view
+***************************************************************************************************/
+
+    namespace impl {
+
+        /// hint that the cache line holding `addr` will be read soon. Never used in constant evaluation.
+        inline void prefetch(const void *addr) noexcept
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            __builtin_prefetch(addr, 0, 0);
+#else
+            (void)addr;
+#endif
+        }
+
+    }   // namespace impl
+
+    /**
+     * Lazy random access range over back-to-back records of format Fmt in a byte buffer. Element `i` is
+     * `unpack_from(fmt, buffer, base + i * calcsize(fmt))`, decoded only when it is dereferenced.
+     * Like `std::vector<bool>` the iterators return their elements by value.
+     */
+    template < typename Fmt >
+    class record_view {
+    public:
+        using value_type = unpack_result_t< Fmt >;
+        static constexpr size_type record_bits = calcsize(Fmt{});
+
+        class iterator {
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+#if bitpacker_CPP20_OR_GREATER
+            using iterator_concept = std::random_access_iterator_tag;
+#endif
+            using value_type = record_view::value_type;
+            using difference_type = std::ptrdiff_t;
+            using reference = value_type;
+            using pointer = void;
+
+            constexpr iterator() noexcept = default;
+            constexpr iterator(span< const byte_type > buffer, size_type base, size_type index, size_type prefetch_distance) noexcept :
+                m_buffer(buffer), m_base(base), m_index(index), m_prefetch(prefetch_distance) {}
+
+            constexpr reference operator*() const { return (*this)[0]; }
+            constexpr reference operator[](difference_type n) const
+            {
+                return impl::unpack< Fmt >(std::make_index_sequence< impl::count_non_padding(Fmt{}) >(), m_buffer,
+                                           m_base + (static_cast< size_type >(static_cast< difference_type >(m_index) + n) * record_bits));
+            }
+
+            constexpr iterator &operator++() noexcept
+            {
+                ++m_index;
+                if (m_prefetch != 0) {
+                    const auto ahead = (m_base + ((m_index + m_prefetch) * record_bits)) / ByteSize;
+                    if (ahead < m_buffer.size()) {
+                        impl::prefetch(&m_buffer[ahead]);
+                    }
+                }
+                return *this;
+            }
+            constexpr iterator operator++(int) noexcept { auto tmp = *this; ++*this; return tmp; }
+            constexpr iterator &operator--() noexcept { --m_index; return *this; }
+            constexpr iterator operator--(int) noexcept { auto tmp = *this; --*this; return tmp; }
+            constexpr iterator &operator+=(difference_type n) noexcept { m_index = static_cast< size_type >(static_cast< difference_type >(m_index) + n); return *this; }
+            constexpr iterator &operator-=(difference_type n) noexcept { return *this += -n; }
+            friend constexpr iterator operator+(iterator it, difference_type n) noexcept { return it += n; }
+            friend constexpr iterator operator+(difference_type n, iterator it) noexcept { return it += n; }
+            friend constexpr iterator operator-(iterator it, difference_type n) noexcept { return it -= n; }
+            friend constexpr difference_type operator-(const iterator &lhs, const iterator &rhs) noexcept
+            {
+                return static_cast< difference_type >(lhs.m_index) - static_cast< difference_type >(rhs.m_index);
+            }
+
+            friend constexpr bool operator==(const iterator &lhs, const iterator &rhs) noexcept { return lhs.m_index == rhs.m_index; }
+            friend constexpr bool operator!=(const iterator &lhs, const iterator &rhs) noexcept { return lhs.m_index != rhs.m_index; }
+            friend constexpr bool operator<(const iterator &lhs, const iterator &rhs) noexcept { return lhs.m_index < rhs.m_index; }
+            friend constexpr bool operator>(const iterator &lhs, const iterator &rhs) noexcept { return lhs.m_index > rhs.m_index; }
+            friend constexpr bool operator<=(const iterator &lhs, const iterator &rhs) noexcept { return lhs.m_index <= rhs.m_index; }
+            friend constexpr bool operator>=(const iterator &lhs, const iterator &rhs) noexcept { return lhs.m_index >= rhs.m_index; }
+
+        private:
+            span< const byte_type > m_buffer{};
+            size_type m_base = 0;
+            size_type m_index = 0;
+            size_type m_prefetch = 0;
+        };
+
+        constexpr record_view() noexcept = default;
+
+        /**
+         * @param buffer [IN] bytes holding the records. Only whole records are part of the range.
+         * @param base [IN] bit offset of the first record
+         * @param prefetch_distance [IN] if not 0, incrementing an iterator prefetches the record this many records ahead
+         */
+        constexpr explicit record_view(span< const byte_type > buffer, size_type base = 0, size_type prefetch_distance = 0) noexcept :
+            m_buffer(buffer), m_base(base), m_prefetch(prefetch_distance),
+            m_count(buffer.size() * ByteSize > base ? ((buffer.size() * ByteSize) - base) / record_bits : 0) {}
+
+        constexpr iterator begin() const noexcept { return {m_buffer, m_base, 0, m_prefetch}; }
+        constexpr iterator end() const noexcept { return {m_buffer, m_base, m_count, m_prefetch}; }
+        constexpr size_type size() const noexcept { return m_count; }
+        constexpr bool empty() const noexcept { return m_count == 0; }
+        constexpr value_type operator[](size_type i) const { return begin()[static_cast< std::ptrdiff_t >(i)]; }
+        constexpr value_type front() const { return (*this)[0]; }
+        constexpr value_type back() const { return (*this)[m_count - 1]; }
+
+    private:
+        span< const byte_type > m_buffer{};
+        size_type m_base = 0;
+        size_type m_prefetch = 0;
+        size_type m_count = 0;
+    };
+
+    /**
+     * Create a lazy random access range over the back-to-back records of format fmt in packedInput.
+     * @param fmt [IN] format string created with macro `BP_STRING()`
+     * @param packedInput [IN] span of bytes holding the records
+     * @param base [IN] bit offset of the first record
+     * @param prefetch_distance [IN] if not 0, iterating prefetches the record this many records ahead
+     * @return `record_view<Fmt>` over every whole record in packedInput after `base`
+     */
+    template < typename Fmt >
+    constexpr record_view< Fmt > records(Fmt /*unused*/, span< const byte_type > packedInput, const size_type base = 0,
+                                         const size_type prefetch_distance = 0) noexcept
+    {
+        return record_view< Fmt >(packedInput, base, prefetch_distance);
+    }
+
+/***************************************************************************************************
+* Tagged union formats
+***************************************************************************************************/
+
+    namespace impl {
+
+        /// largest tag value accepted by `tagged()`, the dispatch tables have one entry per tag value
+        constexpr size_type max_tag_value = 1023;
+
+        /// one alternative of a tagged format: the payload format Fmt, selected by the tag value Tag
+        template < size_type Tag, typename Fmt >
+        struct tagged_alternative {
+            static constexpr size_type tag = Tag;
+            using format = Fmt;
+        };
+
+        template < size_type N >
+        constexpr bool unique_tags(const std::array< size_type, N > &tags) noexcept
+        {
+            for (size_type i = 0; i < N; ++i) {
+                for (size_type j = i + 1; j < N; ++j) {
+                    if (tags[i] == tags[j]) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        template < size_type N >
+        constexpr size_type max_value(const std::array< size_type, N > &values) noexcept
+        {
+            size_type result = 0;
+            for (const auto v : values) {
+                result = v > result ? v : result;
+            }
+            return result;
+        }
+
+        /// true if every value fits in an unsigned field of `bits` bits
+        template < size_type N >
+        constexpr bool fit_in_bits(const std::array< size_type, N > &values, const size_type bits) noexcept
+        {
+            return bits >= 64 || static_cast< uint64_t >(impl::max_value(values)) < (uint64_t{1} << bits);
+        }
+
+    }  // namespace impl
+
+    /**
+     * Tagged union format: a tag format holding one unsigned field, followed by the payload format selected by
+     * the value of that field. Created with `tagged()`, and decoded to a `std::variant`.
+     */
+    template < typename TagFmt, typename... Alternatives >
+    struct tagged_format {
+        using tag_format = TagFmt;
+        using alternatives = std::tuple< Alternatives... >;
+        /// index 0 (std::monostate) is an unknown tag, index I + 1 is the unpacked payload of alternative I
+        using value_type = std::variant< std::monostate, unpack_result_t< typename Alternatives::format >... >;
+
+        static constexpr std::array< size_type, sizeof...(Alternatives) > tags = { Alternatives::tag... };
+        static constexpr size_type max_tag = impl::max_value(tags);
+        static constexpr size_type tag_bits = calcsize(TagFmt{});
+        /// the number of bits used by the largest alternative, including the tag
+        static constexpr size_type max_bits = tag_bits + impl::max_value(std::array< size_type, sizeof...(Alternatives) >{ calcsize(typename Alternatives::format{})... });
+    };
+
+    /**
+     * Declare the payload format used for one tag value of a tagged format.
+     * @tparam Tag tag value that selects this format
+     * @param fmt [IN] format string created with macro `BP_STRING()`
+     */
+    template < size_type Tag, typename Fmt >
+    constexpr impl::tagged_alternative< Tag, Fmt > alternative(Fmt /*unused*/) noexcept
+    {
+        static_assert(std::is_base_of< impl::format_string, Fmt >::value, "bitpacker::alternative : argument must be a format created with BP_STRING()");
+        return {};
+    }
+
+    /**
+     * Create a tagged union format, where the value of the single field in tag_fmt selects the format of the rest of the data.
+     * @param tag_fmt [IN] format string with exactly one non-padding field, which must be unsigned
+     * @param alternatives... [IN] one `alternative<Tag>(fmt)` per known tag value
+     * @return `tagged_format` to use with `unpack_variant()` and `pack_variant()`
+     */
+    template < typename TagFmt, typename... Alternatives >
+    constexpr tagged_format< TagFmt, Alternatives... > tagged(TagFmt /*unused*/, Alternatives... /*unused*/) noexcept
+    {
+        static_assert(sizeof...(Alternatives) > 0, "bitpacker::tagged : at least one alternative is needed");
+        static_assert(impl::count_non_padding(TagFmt{}) == 1, "bitpacker::tagged : tag format must have exactly one non-padding field");
+        static_assert(impl::layout< TagFmt >::fields[0].formatChar == 'u', "bitpacker::tagged : tag field must be unsigned");
+        static_assert(impl::unique_tags(tagged_format< TagFmt, Alternatives... >::tags), "bitpacker::tagged : tag values must be unique");
+        static_assert(tagged_format< TagFmt, Alternatives... >::max_tag <= impl::max_tag_value, "bitpacker::tagged : tag values must be 1023 or less");
+        static_assert(impl::fit_in_bits(tagged_format< TagFmt, Alternatives... >::tags, impl::layout< TagFmt >::fields[0].count),
+                      "bitpacker::tagged : every tag value must fit in the tag field");
+        return {};
+    }
+
+    namespace impl {
+
+        template < typename Tagged >
+        using tagged_unpack_fn = typename Tagged::value_type (*)(span< const byte_type >, size_type);
+
+        template < typename Tagged >
+        using tagged_pack_fn = size_type (*)(span< byte_type >, size_type, const typename Tagged::value_type &);
+
+        template < typename Tagged >
+        constexpr typename Tagged::value_type unpack_unknown_alternative(span< const byte_type > /*unused*/, size_type /*unused*/)
+        {
+            return {};
+        }
+
+        template < typename Tagged, size_type Index >
+        constexpr typename Tagged::value_type unpack_alternative(span< const byte_type > input, size_type payload_bit)
+        {
+            using Fmt = typename std::tuple_element_t< Index, typename Tagged::alternatives >::format;
+            return typename Tagged::value_type(std::in_place_index< Index + 1 >,
+                                               impl::unpack< Fmt >(std::make_index_sequence< impl::count_non_padding(Fmt{}) >(), input, payload_bit));
+        }
+
+        /// the unpack function for each tag value, indexed by tag
+        template < typename Tagged, size_type... Idx >
+        constexpr auto make_unpack_table(std::index_sequence< Idx... > /*unused*/)
+        {
+            std::array< tagged_unpack_fn< Tagged >, Tagged::max_tag + 1 > table{};
+            for (auto &fn : table) {
+                fn = &unpack_unknown_alternative< Tagged >;
+            }
+            int _[] = { 0, (table[std::tuple_element_t< Idx, typename Tagged::alternatives >::tag] = &unpack_alternative< Tagged, Idx >, 0)... };
+            (void)_; // _ is a dummy for pack expansion
+            return table;
+        }
+
+        template < typename Tagged >
+        constexpr size_type pack_unknown_alternative(span< byte_type > /*unused*/, size_type /*unused*/, const typename Tagged::value_type & /*unused*/)
+        {
+            return 0;
+        }
+
+        template < typename Tagged, size_type Index >
+        constexpr size_type pack_alternative(span< byte_type > output, size_type start_bit, const typename Tagged::value_type &value)
+        {
+            using Alternative = std::tuple_element_t< Index, typename Tagged::alternatives >;
+            using Fmt = typename Alternative::format;
+            impl::pack< typename Tagged::tag_format >(output, start_bit, std::make_index_sequence< 1 >(), Alternative::tag);
+            std::apply([&](const auto &... args) {
+                impl::pack< Fmt >(output, start_bit + Tagged::tag_bits, std::make_index_sequence< impl::count_non_padding(Fmt{}) >(), args...);
+            }, std::get< Index + 1 >(value));
+            return Tagged::tag_bits + calcsize(Fmt{});
+        }
+
+        /// the pack function for each variant index, index 0 (std::monostate) packs nothing
+        template < typename Tagged, size_type... Idx >
+        constexpr auto make_pack_table(std::index_sequence< Idx... > /*unused*/)
+        {
+            return std::array< tagged_pack_fn< Tagged >, sizeof...(Idx) + 1 >{ &pack_unknown_alternative< Tagged >, &pack_alternative< Tagged, Idx >... };
+        }
+
+        /// compile time jump tables for a tagged format
+        template < typename Tagged >
+        struct tagged_dispatch {
+            static constexpr auto unpack_table = impl::make_unpack_table< Tagged >(std::make_index_sequence< std::tuple_size< typename Tagged::alternatives >::value >());
+            static constexpr auto pack_table = impl::make_pack_table< Tagged >(std::make_index_sequence< std::tuple_size< typename Tagged::alternatives >::value >());
+        };
+
+    }  // namespace impl
+
+    /**
+     * Unpack a tagged format from packedInput starting at bit `offset`. The tag selects the payload format
+     * through a compile time jump table.
+     * @param tagged_fmt [IN] format created with `tagged()`
+     * @param packedInput [IN] span of bytes to unpack
+     * @param offset [IN] bit index of the tag
+     * @return variant holding the unpacked payload tuple, or std::monostate if the tag is unknown
+     */
+    template < typename TagFmt, typename... Alternatives >
+    constexpr auto unpack_variant_from(tagged_format< TagFmt, Alternatives... > /*unused*/, span< const byte_type > packedInput, const size_type offset)
+    {
+        using Tagged = tagged_format< TagFmt, Alternatives... >;
+        const size_type tag = std::get< 0 >(impl::unpack< TagFmt >(std::make_index_sequence< 1 >(), packedInput, offset));
+        if (tag > Tagged::max_tag) {
+            return typename Tagged::value_type{};
+        }
+        return impl::tagged_dispatch< Tagged >::unpack_table[tag](packedInput, offset + Tagged::tag_bits);
+    }
+
+    /**
+     * Unpack a tagged format from the start of packedInput.
+     * @param tagged_fmt [IN] format created with `tagged()`
+     * @param packedInput [IN] span of bytes to unpack
+     * @return variant holding the unpacked payload tuple, or std::monostate if the tag is unknown
+     */
+    template < typename TagFmt, typename... Alternatives >
+    constexpr auto unpack_variant(tagged_format< TagFmt, Alternatives... > tagged_fmt, span< const byte_type > packedInput)
+    {
+        return unpack_variant_from(tagged_fmt, packedInput, 0);
+    }
+
+    /**
+     * Pack the tag and payload of the alternative held by `value` into output, starting at bit `offset`.
+     * Nothing is written for std::monostate.
+     * @param tagged_fmt [IN] format created with `tagged()`
+     * @param output [OUT] span of bytes to pack into, must have room for the alternative held by `value`
+     * @param offset [IN] bit index to start packing at
+     * @param value [IN] variant of the same type `unpack_variant()` returns
+     * @return number of bits written
+     */
+    template < typename TagFmt, typename... Alternatives >
+    constexpr size_type pack_variant_into(tagged_format< TagFmt, Alternatives... > /*unused*/, span< byte_type > output, const size_type offset,
+                                          const typename tagged_format< TagFmt, Alternatives... >::value_type &value)
+    {
+        using Tagged = tagged_format< TagFmt, Alternatives... >;
+        if (value.valueless_by_exception()) {
+            return 0;
+        }
+        return impl::tagged_dispatch< Tagged >::pack_table[value.index()](output, offset, value);
+    }
+
+    /**
+     * Pack the tag and payload of the alternative held by `value` into an array big enough for any alternative.
+     * @param tagged_fmt [IN] format created with `tagged()`
+     * @param value [IN] variant of the same type `unpack_variant()` returns
+     * @return std::array of bytes holding the packed data
+     */
+    template < typename TagFmt, typename... Alternatives >
+    constexpr auto pack_variant(tagged_format< TagFmt, Alternatives... > tagged_fmt, const typename tagged_format< TagFmt, Alternatives... >::value_type &value)
+    {
+        std::array< byte_type, impl::bit2byte(tagged_format< TagFmt, Alternatives... >::max_bits) > output{};
+        pack_variant_into(tagged_fmt, output, 0, value);
+        return output;
+    }
+
+/***************************************************************************************************
+* Message registry
+***************************************************************************************************/
+
+    namespace impl {
+
+        /// one message of a registry: the payload format Fmt for message id Id, and the handler to call with its fields
+        template < size_type Id, typename Fmt, typename Handler >
+        struct message_entry {
+            static constexpr size_type id = Id;
+            using format = Fmt;
+            Handler handler;
+        };
+
+        /// splitmix64 finalizer, spreads every bit of the key over the whole result
+        constexpr uint64_t mix64(uint64_t x) noexcept
+        {
+            x ^= x >> 30U;
+            x *= 0xBF58476D1CE4E5B9ULL;
+            x ^= x >> 27U;
+            x *= 0x94D049BB133111EBULL;
+            x ^= x >> 31U;
+            return x;
+        }
+
+        /// smallest power of two >= n
+        constexpr size_type ceil_pow2(size_type n) noexcept
+        {
+            size_type result = 1;
+            while (result < n) {
+                result <<= 1U;
+            }
+            return result;
+        }
+
+        /**
+         * Minimal hash-and-displace perfect hash over N keys: each key picks a bucket, and each bucket stores the
+         * displacement that sends all of its keys to free slots. A lookup is two hashes and two table reads.
+         */
+        template < size_type N >
+        struct perfect_hash {
+            static constexpr size_type slot_count = ceil_pow2(2 * N);
+            static constexpr size_type no_key = N;
+            /// how many displacements to try for one bucket before giving up
+            static constexpr uint64_t max_displacement = 1U << 16U;
+
+            std::array< uint64_t, N > displacement{};
+            std::array< size_type, slot_count > key_index{};  //< index of the key in each slot, `no_key` if empty
+            bool found = false;
+
+            static constexpr size_type bucket(uint64_t key) noexcept { return static_cast< size_type >(mix64(key) % N); }
+            static constexpr size_type slot(uint64_t key, uint64_t d) noexcept
+            {
+                return static_cast< size_type >(mix64(key + ((d + 1) * 0x9E3779B97F4A7C15ULL)) & (slot_count - 1));
+            }
+
+            /// index of the key that could be `key`, or `no_key`. The caller must compare the keys.
+            constexpr size_type find(uint64_t key) const noexcept { return key_index[slot(key, displacement[bucket(key)])]; }
+        };
+
+        template < size_type N >
+        constexpr perfect_hash< N > make_perfect_hash(const std::array< size_type, N > &keys) noexcept
+        {
+            using hash = perfect_hash< N >;
+            hash h{};
+            for (auto &k : h.key_index) {
+                k = hash::no_key;
+            }
+            std::array< size_type, N > bucket_size{};
+            for (const auto key : keys) {
+                ++bucket_size[hash::bucket(key)];
+            }
+
+            // place the largest buckets first, while the table is still empty
+            for (size_type size = N; size > 0; --size) {
+                for (size_type b = 0; b < N; ++b) {
+                    if (bucket_size[b] != size) {
+                        continue;
+                    }
+                    bool placed = false;
+                    for (uint64_t d = 0; d < hash::max_displacement && !placed; ++d) {
+                        placed = true;
+                        for (size_type i = 0; i < N && placed; ++i) {
+                            if (hash::bucket(keys[i]) != b) {
+                                continue;
+                            }
+                            auto &s = h.key_index[hash::slot(keys[i], d)];
+                            if (s == hash::no_key) {
+                                s = i;
+                            }
+                            else {
+                                placed = false;
+                            }
+                        }
+                        if (!placed) {
+                            // undo the slots taken by this bucket before trying the next displacement
+                            for (auto &s : h.key_index) {
+                                if (s != hash::no_key && hash::bucket(keys[s]) == b) {
+                                    s = hash::no_key;
+                                }
+                            }
+                        }
+                        else {
+                            h.displacement[b] = d;
+                        }
+                    }
+                    if (!placed) {
+                        return h;
+                    }
+                }
+            }
+            h.found = true;
+            return h;
+        }
+
+        template < size_type Index, typename Entry >
+        struct registry_leaf {
+            Entry entry;
+        };
+
+        /// flat storage for the messages of a registry. Unlike a std::tuple it doesn't nest, which keeps large registries cheap to compile.
+        template < typename Seq, typename... Entries >
+        struct registry_storage;
+
+        template < size_type... Idx, typename... Entries >
+        struct registry_storage< std::index_sequence< Idx... >, Entries... > : registry_leaf< Idx, Entries >... {
+            constexpr explicit registry_storage(Entries... entries) : registry_leaf< Idx, Entries >{ std::move(entries) }... {}
+        };
+
+        /// entry Index of a registry_storage, found by overload resolution on the leaf base class
+        template < size_type Index, typename Entry >
+        constexpr Entry &registry_entry(registry_leaf< Index, Entry > &leaf) noexcept
+        {
+            return leaf.entry;
+        }
+
+        template < typename... Entries >
+        using registry_storage_t = registry_storage< std::index_sequence_for< Entries... >, Entries... >;
+
+        template < typename... Entries >
+        using registry_fn = void (*)(registry_storage_t< Entries... > &, span< const byte_type >, size_type);
+
+        /// unpack the payload of message Index and call its handler with the fields
+        template < size_type Index, typename... Entries >
+        constexpr void dispatch_entry(registry_storage_t< Entries... > &entries, span< const byte_type > input, size_type payload_bit)
+        {
+            auto &entry = impl::registry_entry< Index >(entries);
+            using Fmt = typename std::remove_reference_t< decltype(entry) >::format;
+            std::apply(entry.handler, impl::unpack< Fmt >(std::make_index_sequence< impl::count_non_padding(Fmt{}) >(), input, payload_bit));
+        }
+
+        /// compile time dispatch tables for a registry: a dense table indexed by id for small ids, a perfect hash otherwise
+        template < typename... Entries >
+        struct registry_dispatch {
+            using fn_type = registry_fn< Entries... >;
+            static constexpr size_type count = sizeof...(Entries);
+            static constexpr std::array< size_type, count > ids = { Entries::id... };
+            static constexpr size_type max_id = impl::max_value(ids);
+            static constexpr bool dense = max_id <= impl::max_tag_value;
+
+            template < size_type... Idx >
+            static constexpr std::array< fn_type, count > make_functions(std::index_sequence< Idx... > /*unused*/) noexcept
+            {
+                return { &dispatch_entry< Idx, Entries... >... };
+            }
+            static constexpr auto functions = make_functions(std::index_sequence_for< Entries... >());
+
+            static constexpr auto make_dense_table() noexcept
+            {
+                std::array< fn_type, dense ? max_id + 1 : 1 > table{};
+                if (dense) {
+                    for (size_type i = 0; i < count; ++i) {
+                        table[ids[i]] = functions[i];
+                    }
+                }
+                return table;
+            }
+            static constexpr auto dense_table = make_dense_table();
+            static constexpr auto hash = dense ? perfect_hash< count >{} : impl::make_perfect_hash(ids);
+
+            /// the function for message `id`, nullptr if the id is unknown
+            static constexpr fn_type lookup(const size_type id) noexcept
+            {
+                if constexpr (dense) {
+                    return id <= max_id ? dense_table[id] : nullptr;
+                }
+                else {
+                    const auto index = hash.find(id);
+                    return (index != perfect_hash< count >::no_key && ids[index] == id) ? functions[index] : nullptr;
+                }
+            }
+        };
+
+    }  // namespace impl
+
+    /**
+     * Registry of message formats and handlers, selected by an id field in front of every message.
+     * Created with `registry()`.
+     */
+    template < typename IdFmt, typename... Entries >
+    class message_registry {
+        using dispatch_type = impl::registry_dispatch< Entries... >;
+
+    public:
+        using id_format = IdFmt;
+        static constexpr size_type id_bits = calcsize(IdFmt{});
+        /// true if the messages are found with a table indexed by id, false if they are found with a perfect hash
+        static constexpr bool dense = dispatch_type::dense;
+
+        constexpr explicit message_registry(Entries... entries) : m_entries(std::move(entries)...) {}
+
+        /**
+         * Read the id at bit `offset`, unpack the message that follows with the format registered for that id and
+         * call its handler with the unpacked fields.
+         * @param packedInput [IN] span of bytes holding the message
+         * @param offset [IN] bit index of the id
+         * @return false if the id is not registered, nothing is unpacked then
+         */
+        constexpr bool dispatch(span< const byte_type > packedInput, const size_type offset = 0)
+        {
+            const size_type id = std::get< 0 >(impl::unpack< IdFmt >(std::make_index_sequence< 1 >(), packedInput, offset));
+            const auto fn = dispatch_type::lookup(id);
+            if (fn == nullptr) {
+                return false;
+            }
+            fn(m_entries, packedInput, offset + id_bits);
+            return true;
+        }
+
+    private:
+        impl::registry_storage_t< Entries... > m_entries;
+    };
+
+    /**
+     * Declare one message of a registry.
+     * @tparam Id message id that selects this message
+     * @param fmt [IN] format string of the message after the id, created with macro `BP_STRING()`
+     * @param handler [IN] callable taking one argument per non-padding field of fmt
+     */
+    template < size_type Id, typename Fmt, typename Handler >
+    constexpr impl::message_entry< Id, Fmt, std::decay_t< Handler > > message(Fmt /*unused*/, Handler &&handler)
+    {
+        static_assert(std::is_base_of< impl::format_string, Fmt >::value, "bitpacker::message : argument must be a format created with BP_STRING()");
+        return { std::forward< Handler >(handler) };
+    }
+
+    /**
+     * Create a registry that unpacks and handles messages according to the id in front of them. Ids up to 1023
+     * are looked up in a table indexed by id; larger ids use a perfect hash built at compile time.
+     * @param id_fmt [IN] format with exactly one non-padding field, which must be unsigned
+     * @param messages... [IN] one `message<Id>(fmt, handler)` per message type
+     * @return `message_registry`, call `dispatch()` on it for each message
+     */
+    template < typename IdFmt, typename... Entries >
+    constexpr message_registry< IdFmt, Entries... > registry(IdFmt /*unused*/, Entries... messages)
+    {
+        static_assert(sizeof...(Entries) > 0, "bitpacker::registry : at least one message is needed");
+        static_assert(impl::count_non_padding(IdFmt{}) == 1, "bitpacker::registry : id format must have exactly one non-padding field");
+        static_assert(impl::layout< IdFmt >::fields[0].formatChar == 'u', "bitpacker::registry : id field must be unsigned");
+        static_assert(impl::unique_tags(impl::registry_dispatch< Entries... >::ids), "bitpacker::registry : message ids must be unique");
+        static_assert(impl::fit_in_bits(impl::registry_dispatch< Entries... >::ids, impl::layout< IdFmt >::fields[0].count),
+                      "bitpacker::registry : every message id must fit in the id field");
+        static_assert(impl::registry_dispatch< Entries... >::dense || impl::registry_dispatch< Entries... >::hash.found,
+                      "bitpacker::registry : no perfect hash found for these message ids");
+        return message_registry< IdFmt, Entries... >(std::move(messages)...);
+    }
+
+/***************************************************************************************************
+* Message templates
+***************************************************************************************************/
+
+    /// placeholder passed to `prebake()` for a field that is filled in each time the message is sent
+    struct hole_t {
+        explicit constexpr hole_t(int /*unused*/) noexcept {}
+    };
+    inline constexpr hole_t hole{0};
+
+    /**
+     * A message of format Fmt packed ahead of time, except for the non-padding fields Holes... (in increasing order).
+     * Created with `prebake()`. Sending copies the image and writes only the holes, so the bound fields and the
+     * padding are never packed again.
+     */
+    template < typename Fmt, size_type... Holes >
+    class message_template {
+    public:
+        using format = Fmt;
+        using image_type = std::array< byte_type, calcbytes(Fmt{}) >;
+        static constexpr size_type hole_count = sizeof...(Holes);
+        /// the non-padding field index of each hole, in the order `pack()` and `fill()` take them
+        static constexpr std::array< size_type, hole_count > holes = { Holes... };
+
+        constexpr explicit message_template(const image_type &image) noexcept : m_image(image) {}
+
+        /// the packed message with every hole set to zero
+        constexpr const image_type &image() const noexcept { return m_image; }
+
+        /// copy of the image with the holes set to args...
+        template < typename... Args >
+        constexpr image_type pack(const Args &... args) const
+        {
+            image_type output = m_image;
+            fill(output, args...);
+            return output;
+        }
+
+        /**
+         * Write only the holes into output, which must already hold the image (for example a transmit buffer that was
+         * set from `image()` once). Bits outside the holes are not modified.
+         * @param output [IN/OUT] span of bytes holding the message, starting at its first byte
+         * @param args... [IN] one value per hole
+         */
+        template < typename... Args >
+        constexpr void fill([[maybe_unused]] span< byte_type > output, const Args &... args) const
+        {
+            static_assert(sizeof...(Args) == hole_count, "bitpacker::message_template : expected one argument per hole");
+            int _[] = { 0, impl::packElement< typename impl::field_info< Fmt, Holes >::type >(output, impl::field_info< Fmt, Holes >::offset, args)... };
+            (void)_; // _ is a dummy for pack expansion
+        }
+
+    private:
+        image_type m_image;
+    };
+
+    namespace impl {
+
+        /// the indices of IsHole... that are equal to Want
+        template < bool Want, bool... IsHole >
+        struct select_fields {
+            static constexpr size_type count = (size_type{0} + ... + (IsHole == Want ? 1U : 0U));
+
+            static constexpr std::array< size_type, count > make() noexcept
+            {
+                constexpr std::array< bool, sizeof...(IsHole) > mask = { IsHole... };
+                std::array< size_type, count > result{};
+                size_type n = 0;
+                for (size_type i = 0; i < mask.size(); ++i) {
+                    if (mask[i] == Want) {
+                        result[n++] = i;
+                    }
+                }
+                return result;
+            }
+
+            static constexpr std::array< size_type, count > indices = make();
+        };
+
+        template < typename Select, size_type... J >
+        constexpr auto selected_sequence(std::index_sequence< J... > /*unused*/) noexcept
+        {
+            return std::index_sequence< Select::indices[J]... >{};
+        }
+
+        /// pack the fields Bound... of args into the image of a template with the holes Holes...
+        template < typename Fmt, size_type... Bound, size_type... Holes, typename Args >
+        constexpr message_template< Fmt, Holes... > prebake(std::index_sequence< Bound... > seq, std::index_sequence< Holes... > /*unused*/, const Args &args)
+        {
+            typename message_template< Fmt, Holes... >::image_type image{};
+            impl::pack< Fmt >(image, 0, seq, std::get< Bound >(args)...);
+            return message_template< Fmt, Holes... >(image);
+        }
+
+    }  // namespace impl
+
+    /**
+     * Pack a message template: a message with some fields bound now (at compile time if used in a constexpr
+     * context) and the rest left as holes, to be filled with `pack()` or `fill()` each time it is sent.
+     * @code
+     *     constexpr auto heartbeat = bitpacker::prebake(BP_STRING("u4u12p4u32u16b1"), 2, 0x123, bitpacker::hole, bitpacker::hole, true);
+     *     const auto frame = heartbeat.pack(sequence, uptime);
+     * @endcode
+     * @param fmt [IN] format string created with macro `BP_STRING()`
+     * @param args... [IN] one value per non-padding field, or `bitpacker::hole` for a field to fill in later
+     * @return `message_template` holding the packed image
+     */
+    template < typename Fmt, typename... Args >
+    constexpr auto prebake(Fmt /*unused*/, const Args &... args)
+    {
+        static_assert(sizeof...(Args) == impl::count_non_padding(Fmt{}), "bitpacker::prebake : expected one argument (or bitpacker::hole) per non-padding field");
+        using holes = impl::select_fields< true, std::is_same< Args, hole_t >::value... >;
+        using bound = impl::select_fields< false, std::is_same< Args, hole_t >::value... >;
+        return impl::prebake< Fmt >(impl::selected_sequence< bound >(std::make_index_sequence< bound::count >()),
+                                    impl::selected_sequence< holes >(std::make_index_sequence< holes::count >()),
+                                    std::forward_as_tuple(args...));
     }
 
 } // namespace bitpacker
 
+namespace std {
+    // structured binding support for large_record
+    template < typename Fmt >
+    struct tuple_size< bitpacker::large_record< Fmt > > : std::integral_constant< std::size_t, bitpacker::large_record< Fmt >::field_count > {};
+
+    template < std::size_t I, typename Fmt >
+    struct tuple_element< I, bitpacker::large_record< Fmt > > {
+        using type = typename bitpacker::impl::field_type< Fmt, I >::return_type;
+    };
+
+    // structured binding support for format_view. Each binding is a proxy, decoded only when it is read.
+    template < typename Fmt >
+    struct tuple_size< bitpacker::format_view< Fmt > > : std::integral_constant< std::size_t, bitpacker::format_view< Fmt >::field_count > {};
+
+    template < std::size_t I, typename Fmt >
+    struct tuple_element< I, bitpacker::format_view< Fmt > > {
+        using type = const bitpacker::const_field_ref< Fmt, I >;
+    };
+}  // namespace std
+
+#if defined(__cpp_lib_ranges)
+#include <ranges>
+// record_view is a non-owning view: iterators stay valid after the view is destroyed
+template < typename Fmt >
+inline constexpr bool std::ranges::enable_borrowed_range< bitpacker::record_view< Fmt > > = true;
+template < typename Fmt >
+inline constexpr bool std::ranges::enable_view< bitpacker::record_view< Fmt > > = true;
+#endif
+
+#if bitpacker_CPP20_OR_GREATER && ((defined(__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L) \
+                                   || (defined(__cpp_nontype_template_parameter_class) && __cpp_nontype_template_parameter_class >= 201806L))
+# define bitpacker_HAVE_LITERAL_FORMATS  1
+#else
+# define bitpacker_HAVE_LITERAL_FORMATS  0
+#endif
+
+#if bitpacker_HAVE_LITERAL_FORMATS
+namespace bitpacker {
+
+    namespace impl {
+
+        /// a format string literal usable as a template argument
+        template < size_type Length >
+        struct fixed_string {
+            char data[Length + 1]{};
+
+            constexpr fixed_string(const char (&str)[Length + 1]) noexcept  // NOLINT - implicit so literals convert
+            {
+                impl::copy(str, str + Length + 1, data);
+            }
+        };
+
+        template < size_type N >
+        fixed_string(const char (&)[N]) -> fixed_string< N - 1 >;
+
+        /// format type for the literal Str, see `bitpacker::fmt`
+        template < fixed_string Str >
+        struct literal_format : format_string {
+            static constexpr decltype(auto) value() { return (Str.data); }
+            static constexpr size_type size() { return std::size(Str.data) - 1; }
+            static constexpr auto at(size_type i) { return value()[i]; }
+        };
+
+    }  // namespace impl
+
+    /**
+     * Format string given as a template argument: `bitpacker::fmt<"u12b1">`. Unlike `BP_STRING()`, which makes a new type at
+     * every use, the same string always gives the same type, so every pack/unpack instantiation for it is shared between
+     * functions and translation units.
+     */
+    template < impl::fixed_string Str >
+    inline constexpr impl::literal_format< Str > fmt{};
+
+    namespace literals {
+        /// `"u12b1"_bpf` is the same format as `bitpacker::fmt<"u12b1">`
+        template < impl::fixed_string Str >
+        constexpr impl::literal_format< Str > operator""_bpf() noexcept
+        {
+            return {};
+        }
+    }  // namespace literals
+
+}  // namespace bitpacker
+#endif
+
 #define BP_STRING(s) [] { \
     struct S : bitpacker::impl::format_string { \
       static constexpr decltype(auto) value() { return s; } \
@@ -836,6 +3276,6 @@ namespace bitpacker {
     return S{}; \
   }()
 
-#else
-} // namespace bitpacker
 #endif  // bitpacker_CPP17_OR_GREATER
+
+#undef BITPACKER_NOINLINE
@@ -0,0 +1,231 @@
+/**
+ *  BITPACKER
+ *  type-safe and low boilerplate bit-level serialization
+ *  https://github.com/CrustyAuklet/bitpacker
+ *
+ *  Copyright 2020 Ethan Slattery
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+#pragma once
+
+#include "bitpacker.hpp"
+
+#include <exception>
+#include <thread>
+#include <vector>
+
+#if !bitpacker_CPP17_OR_GREATER
+#error "bitpacker/parallel.hpp requires C++17 or later"
+#endif
+
+namespace bitpacker {
+
+    namespace impl {
+
+        /// chunks that are written by different threads start on a (typical) cache line to avoid false sharing
+        constexpr size_type cache_line_bits = 64 * ByteSize;
+
+        /**
+         * The first record at or after `first`, in steps of `step` records, that starts on a cache line of the memory
+         * at `data`. The position of a record in its cache line repeats every lcm(record_bits, cache_line_bits) bits,
+         * so if no record of one such period starts a cache line, `first` is returned.
+         */
+        inline size_type cache_line_record(const void *data, const size_type record_bits, const size_type step, const size_type first) noexcept
+        {
+            // NOLINTNEXTLINE - only the address of the buffer is needed
+            const size_type base_bit = (reinterpret_cast< std::uintptr_t >(data) % (cache_line_bits / ByteSize)) * ByteSize;
+            const size_type period = impl::aligned_record_step(record_bits, cache_line_bits);
+            for (size_type r = first; r < first + period; r += step) {
+                if ((base_bit + (r * record_bits)) % cache_line_bits == 0) {
+                    return r;
+                }
+            }
+            return first;
+        }
+
+        /// the number of threads to use for `threads == 0`
+        inline unsigned default_thread_count() noexcept
+        {
+            const auto hw = std::thread::hardware_concurrency();
+            return hw == 0 ? 1U : hw;
+        }
+
+        /**
+         * Split the records [0, count) into at most `threads` contiguous chunks and call `fn(first, last)` for each,
+         * one chunk per thread. Chunks are first cut every multiple of `step` records, then each cut is moved to
+         * `split(cut)`, which must return a multiple of `step` at or after `cut`. If `fn` throws, the first exception
+         * is rethrown on the calling thread once every chunk is done.
+         */
+        template < typename Split, typename Fn >
+        void parallel_for_records(const size_type count, const size_type step, unsigned threads, Split &&split, Fn &&fn)
+        {
+            if (threads == 0) {
+                threads = impl::default_thread_count();
+            }
+            const size_type steps = (count / step) + ((count % step) ? 1 : 0);
+            if (threads > steps) {
+                threads = static_cast< unsigned >(steps);
+            }
+            if (threads <= 1) {
+                fn(size_type{0}, count);
+                return;
+            }
+
+            const size_type chunk = ((steps + threads - 1) / threads) * step;
+            std::vector< size_type > bounds(threads + 1, count);
+            bounds[0] = 0;
+            for (size_type t = 1; t < threads && t * chunk < count; ++t) {
+                const size_type cut = split(t * chunk);
+                bounds[t] = cut < bounds[t - 1] ? bounds[t - 1] : (cut < count ? cut : count);
+            }
+
+            // one slot per chunk, sized up front so the workers can hold references into it
+            std::vector< std::exception_ptr > errors(threads);
+            std::vector< std::thread > workers;
+            workers.reserve(threads - 1);
+            for (size_type t = 1; t < threads; ++t) {
+                if (bounds[t] == bounds[t + 1]) {
+                    continue;
+                }
+                workers.emplace_back([&fn, &error = errors[t], first = bounds[t], last = bounds[t + 1]] {
+                    try {
+                        fn(first, last);
+                    }
+                    catch (...) {
+                        error = std::current_exception();
+                    }
+                });
+            }
+            // the calling thread does the first chunk itself
+            try {
+                fn(bounds[0], bounds[1]);
+            }
+            catch (...) {
+                errors[0] = std::current_exception();
+            }
+            for (auto &w : workers) {
+                w.join();
+            }
+            for (const auto &error : errors) {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            }
+        }
+
+        /// `split` for `parallel_for_records()` that keeps the cuts where they are
+        constexpr size_type keep_cut(const size_type cut) noexcept
+        {
+            return cut;
+        }
+
+    }  // namespace impl
+
+    /**
+     * Multithreaded `unpack_batch()`. The records are split into contiguous chunks, one per thread, and each
+     * chunk boundary falls on a byte boundary of the input even if `calcsize(fmt)` is not a multiple of 8.
+     * @param fmt [IN] format string created with macro `BP_STRING()`
+     * @param input [IN] span of bytes holding at least `count * calcsize(fmt)` bits
+     * @param count [IN] number of records to unpack
+     * @param threads [IN] maximum number of threads to use, including the calling thread. 0 uses one per hardware thread.
+     * @param output [OUT] indexable container of `unpack_result_t<Fmt>` with room for at least `count` items
+     * @return false, with nothing written, if input or output is too small for `count` records
+     */
+    template < typename Fmt, typename Output >
+    bool parallel_unpack_batch(Fmt /*unused*/, span< const byte_type > input, const size_type count, const unsigned threads,
+                               Output &&output)
+    {
+        if (!impl::batch_fits< Fmt >(input.size(), count) || !impl::holds(output, count)) {
+            return false;
+        }
+        constexpr auto step = impl::aligned_record_step(calcsize(Fmt{}), ByteSize);
+        impl::parallel_for_records(count, step, threads, impl::keep_cut, [&](const size_type first, const size_type last) {
+            impl::unpack_records< Fmt >(input, first, last, output);
+        });
+        return true;
+    }
+
+    /**
+     * Multithreaded `unpack_columns()`. The records are split into contiguous chunks, one per thread, and each
+     * chunk boundary falls on a byte boundary of the input even if `calcsize(fmt)` is not a multiple of 8.
+     * @param fmt [IN] format string created with macro `BP_STRING()`
+     * @param input [IN] span of bytes holding at least `count * calcsize(fmt)` bits
+     * @param count [IN] number of records to unpack
+     * @param threads [IN] maximum number of threads to use, including the calling thread. 0 uses one per hardware thread.
+     * @param columns... [OUT] one indexable container per non-padding field, each with room for at least `count` values.
+     *                    Neighboring elements are written by different threads, so bit-packed containers
+     *                    such as `std::vector<bool>` can not be used.
+     * @return false, with nothing written, if input or a column is too small for `count` records
+     */
+    template < typename Fmt, typename... Columns >
+    bool parallel_unpack_columns(Fmt /*unused*/, span< const byte_type > input, const size_type count, const unsigned threads,
+                                 Columns &&... columns)
+    {
+        if (!impl::batch_fits< Fmt >(input.size(), count) || !(impl::holds(columns, count) && ...)) {
+            return false;
+        }
+        constexpr auto step = impl::aligned_record_step(calcsize(Fmt{}), ByteSize);
+        impl::parallel_for_records(count, step, threads, impl::keep_cut, [&](const size_type first, const size_type last) {
+            impl::unpack_columns< Fmt >(input, first, last, std::make_index_sequence< impl::count_non_padding(Fmt{}) >(), columns...);
+        });
+        return true;
+    }
+
+    /**
+     * Multithreaded `pack_batch()`. Neighboring records share bytes when `calcsize(fmt)` is not a multiple of 8,
+     * so chunks always start on a byte boundary and no byte is written by two threads. To avoid false sharing, each
+     * chunk starts on a record that begins a cache line in memory (the address of the output is taken into
+     * account), if one is found within lcm(calcsize(fmt), 512) bits of the even split.
+     * @param fmt [IN] format string created with macro `BP_STRING()`
+     * @param output [OUT] span of bytes to pack into. Must hold at least `count * calcsize(fmt)` bits.
+     * @param count [IN] number of records to pack
+     * @param threads [IN] maximum number of threads to use, including the calling thread. 0 uses one per hardware thread.
+     * @param records [IN] indexable container of tuples with one value per non-padding field, at least `count` long
+     * @return false, with nothing written, if output or records is too small for `count` records
+     */
+    template < typename Fmt, typename Records >
+    bool parallel_pack_batch(Fmt /*unused*/, span< byte_type > output, const size_type count, const unsigned threads,
+                             const Records &records)
+    {
+        if (!impl::batch_fits< Fmt >(output.size(), count) || !impl::holds(records, count)) {
+            return false;
+        }
+        constexpr auto record_bits = calcsize(Fmt{});
+        constexpr auto step = impl::aligned_record_step(record_bits, ByteSize);
+        const auto to_cache_line = [&output](const size_type cut) { return impl::cache_line_record(output.data(), record_bits, step, cut); };
+        impl::parallel_for_records(count, step, threads, to_cache_line, [&](const size_type first, const size_type last) {
+            impl::pack_records< Fmt >(output, first, last, records);
+        });
+        return true;
+    }
+
+    /**
+     * Multithreaded `pack_columns()`. Chunks are split like in `parallel_pack_batch()`: no byte is written by two
+     * threads, and each chunk starts on a cache line in memory when a record within lcm(calcsize(fmt), 512) bits
+     * of the even split begins one.
+     * @param fmt [IN] format string created with macro `BP_STRING()`
+     * @param output [OUT] span of bytes to pack into. Must hold at least `count * calcsize(fmt)` bits.
+     * @param count [IN] number of records to pack
+     * @param threads [IN] maximum number of threads to use, including the calling thread. 0 uses one per hardware thread.
+     * @param columns... [IN] one indexable container per non-padding field, each holding at least `count` values
+     * @return false, with nothing written, if output or a column is too small for `count` records
+     */
+    template < typename Fmt, typename... Columns >
+    bool parallel_pack_columns(Fmt /*unused*/, span< byte_type > output, const size_type count, const unsigned threads,
+                               const Columns &... columns)
+    {
+        if (!impl::batch_fits< Fmt >(output.size(), count) || !(impl::holds(columns, count) && ...)) {
+            return false;
+        }
+        constexpr auto record_bits = calcsize(Fmt{});
+        constexpr auto step = impl::aligned_record_step(record_bits, ByteSize);
+        const auto to_cache_line = [&output](const size_type cut) { return impl::cache_line_record(output.data(), record_bits, step, cut); };
+        impl::parallel_for_records(count, step, threads, to_cache_line, [&](const size_type first, const size_type last) {
+            impl::pack_columns< Fmt >(output, first, last, std::make_index_sequence< impl::count_non_padding(Fmt{}) >(), columns...);
+        });
+        return true;
+    }
+
+}  // namespace bitpacker
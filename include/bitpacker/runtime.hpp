@@ -0,0 +1,815 @@
+/**
+ *  BITPACKER
+ *  type-safe and low boilerplate bit-level serialization
+ *  https://github.com/CrustyAuklet/bitpacker
+ *
+ *  Copyright 2020 Ethan Slattery
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+#pragma once
+
+#include "bitpacker.hpp"
+
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#if !bitpacker_CPP17_OR_GREATER
+#error "bitpacker/runtime.hpp requires C++17 or later"
+#endif
+
+namespace bitpacker {
+
+    namespace impl {
+
+        enum class parse_result {
+            item,   //< an item was parsed
+            end,    //< there are no more items
+            error   //< the format string is not valid
+        };
+
+        /**
+         * Parse the next item of the format string `fmt`, starting at `pos`. Bit order characters before the item
+         * update `endian`. The result has the same meaning as the items from `get_type_array()`, except that
+         * `offset` is left at 0 for the caller to fill in.
+         * @param fmt [IN] format string
+         * @param pos [IN/OUT] index of the next character to parse, moved past the parsed item
+         * @param endian [IN/OUT] current bit order
+         * @param item [OUT] the parsed item
+         */
+        constexpr parse_result parse_item(std::string_view fmt, size_type &pos, impl::Endian &endian, RawFormatType &item) noexcept
+        {
+            while (pos < fmt.size() && impl::isFormatMode(fmt[pos])) {
+                endian = fmt[pos] == '>' ? impl::Endian::big : impl::Endian::little;
+                ++pos;
+            }
+            if (pos == fmt.size()) {
+                return parse_result::end;
+            }
+
+            const char type = fmt[pos++];
+            if (!impl::isFormatType(type)) {
+                return parse_result::error;
+            }
+
+            const auto consume = [&fmt, &pos](size_type &value) {
+                const auto first = pos;
+                value = 0;
+                for (; pos < fmt.size() && impl::isDigit(fmt[pos]); ++pos) {
+                    value = (value * 10) + static_cast< size_type >(fmt[pos] - '0');
+                }
+                return pos != first && value != 0;
+            };
+
+            size_type bits = 0;
+            size_type repeat = 0;
+            if (!consume(bits)) {
+                return parse_result::error;
+            }
+            if (pos < fmt.size() && fmt[pos] == '[') {
+                ++pos;
+                if (!consume(repeat) || pos == fmt.size() || fmt[pos] != ']') {
+                    return parse_result::error;
+                }
+                ++pos;
+            }
+
+            item = RawFormatType{};
+            item.formatChar = type;
+            item.count = repeat != 0 ? bits * repeat : bits;
+            item.endian = endian;
+            item.repeat = repeat;
+            return parse_result::item;
+        }
+
+        /// reverse the order of all 64 bits of `v`
+        constexpr uint64_t reverse_bits64(uint64_t v) noexcept
+        {
+            v = ((v >> 1U) & 0x5555555555555555ULL) | ((v & 0x5555555555555555ULL) << 1U);
+            v = ((v >> 2U) & 0x3333333333333333ULL) | ((v & 0x3333333333333333ULL) << 2U);
+            v = ((v >> 4U) & 0x0F0F0F0F0F0F0F0FULL) | ((v & 0x0F0F0F0F0F0F0F0FULL) << 4U);
+            v = ((v >> 8U) & 0x00FF00FF00FF00FFULL) | ((v & 0x00FF00FF00FF00FFULL) << 8U);
+            v = ((v >> 16U) & 0x0000FFFF0000FFFFULL) | ((v & 0x0000FFFF0000FFFFULL) << 16U);
+            return (v >> 32U) | (v << 32U);
+        }
+
+        /// reverse the order of the 8 bytes of `v`
+        constexpr uint64_t byte_swap64(uint64_t v) noexcept
+        {
+            v = ((v >> 8U) & 0x00FF00FF00FF00FFULL) | ((v & 0x00FF00FF00FF00FFULL) << 8U);
+            v = ((v >> 16U) & 0x0000FFFF0000FFFFULL) | ((v & 0x0000FFFF0000FFFFULL) << 16U);
+            return (v >> 32U) | (v << 32U);
+        }
+
+        /// the IEEE half precision value closest to the double with bit pattern `d`, rounding to nearest even
+        inline uint64_t double_to_half(const uint64_t d) noexcept
+        {
+            const uint64_t sign = (d >> 48U) & 0x8000U;
+            const auto exponent = static_cast< int64_t >((d >> 52U) & 0x7FFU);
+            const uint64_t mantissa = d & ((uint64_t{1} << 52U) - 1);
+            if (exponent == 0x7FF) {
+                return sign | 0x7C00U | (mantissa != 0 ? 0x200U : 0U);
+            }
+            const int64_t e = exponent - 1023 + 15;
+            if (e >= 31) {
+                return sign | 0x7C00U;
+            }
+            // normal values keep the top 10 mantissa bits, subnormal values shift the implicit bit in as well
+            uint64_t m = mantissa;
+            uint64_t h = static_cast< uint64_t >(e) << 10U;
+            size_type shift = 42;
+            if (e <= 0) {
+                if (43 - e >= 64) {
+                    return sign;
+                }
+                m |= uint64_t{1} << 52U;
+                h = 0;
+                shift = static_cast< size_type >(43 - e);
+            }
+            h |= m >> shift;
+            const uint64_t rest = m & ((uint64_t{1} << shift) - 1);
+            const uint64_t half = uint64_t{1} << (shift - 1);
+            if (rest > half || (rest == half && (h & 1U) != 0)) {
+                ++h;  // a carry into the exponent is still the right result, up to infinity
+            }
+            return sign | h;
+        }
+
+        /// the bit pattern of the double equal to the IEEE half precision value `h`
+        inline uint64_t half_to_double(const uint64_t h) noexcept
+        {
+            const uint64_t sign = (h & 0x8000U) << 48U;
+            const uint64_t exponent = (h >> 10U) & 0x1FU;
+            const uint64_t mantissa = h & 0x3FFU;
+            if (exponent == 0x1F) {
+                return sign | (uint64_t{0x7FF} << 52U) | (mantissa << 42U);
+            }
+            if (exponent != 0) {
+                return sign | ((exponent - 15 + 1023) << 52U) | (mantissa << 42U);
+            }
+            if (mantissa == 0) {
+                return sign;
+            }
+            // subnormal: normalize the mantissa, the double has plenty of exponent range
+            uint64_t e = 1023 - 14;
+            uint64_t m = mantissa;
+            while ((m & 0x400U) == 0) {
+                m <<= 1U;
+                --e;
+            }
+            return sign | (e << 52U) | ((m & 0x3FFU) << 42U);
+        }
+
+        /// the `bits` bit IEEE float closest to the double with bit pattern `d`
+        inline uint64_t double_to_float_bits(const uint64_t d, const unsigned bits) noexcept
+        {
+            if (bits == 32U) {
+                double value = 0;
+                std::memcpy(&value, &d, sizeof(value));
+                const auto single = static_cast< float >(value);
+                uint32_t result = 0;
+                std::memcpy(&result, &single, sizeof(result));
+                return result;
+            }
+            return bits == 16U ? double_to_half(d) : d;
+        }
+
+        /// the bit pattern of the double equal to the `bits` bit IEEE float `f`
+        inline uint64_t float_bits_to_double(const uint64_t f, const unsigned bits) noexcept
+        {
+            if (bits == 32U) {
+                const auto pattern = static_cast< uint32_t >(f);
+                float single = 0;
+                std::memcpy(&single, &pattern, sizeof(single));
+                const auto value = static_cast< double >(single);
+                uint64_t result = 0;
+                std::memcpy(&result, &value, sizeof(result));
+                return result;
+            }
+            return bits == 16U ? half_to_double(f) : f;
+        }
+
+        /// one step of a compiled format: a field of at most 64 bits, or a whole `r`/`t` field
+        struct compiled_op {
+            enum kind_type : uint8_t { unsigned_int, signed_int, boolean, floating, bytes, zeros, ones };
+
+            size_type bit;          //< offset of the field from the start of the format
+            size_type byte;         //< first byte of the field
+            uint64_t sign;          //< sign bit of a signed field, 0 otherwise. `(v ^ sign) - sign` sign extends `v`
+            size_type data;         //< `r`/`t` fields: index of the field's first byte in the byte span
+            size_type data_bits;    //< `r`/`t` fields: number of bits in the field
+            uint8_t shift;          //< left shift that moves the field to the top of the big endian 64 bit word at `byte`
+            uint8_t window;         //< offset of the field from the start of its `compiled_word`
+            uint8_t bits;           //< number of bits in the field, 0 for `r`/`t` fields of more than 64 bits
+            bool fits;              //< true if the field fits in the 64 bit word at `byte`
+            kind_type kind;
+            bool lsb_first;         //< bit order is `<`
+            bool swap;              //< byte order is `<` and the field is more than one byte
+            bool plain;             //< an integer field in big endian bit and byte order, that needs no conversion
+        };
+
+        /// fields read with one 8 byte load and written with one 8 byte read-modify-write: the ops that fit in the
+        /// 64 bits starting at `byte`. An op that doesn't fit in 8 bytes gets a word of its own, with a `mask` of 0.
+        struct compiled_word {
+            size_type byte;         //< first byte of the word
+            size_type ops;          //< number of ops in the word
+            uint64_t mask;          //< the bits of the big endian 64 bit word at `byte` owned by its ops
+            uint64_t fill;          //< the bits of the word set by `P` padding
+        };
+
+        /// read the `bits` bit field at bit `shift` of byte `byte`, one 8 byte load when the field fits in it
+        inline uint64_t read_field(span< const byte_type > input, size_type byte, unsigned shift, unsigned bits) noexcept
+        {
+            if (shift + bits <= 64U && byte + 8 <= input.size()) {
+                return (impl::load_be64(input.data() + byte) << shift) >> (64U - bits);
+            }
+            return extract< uint64_t >(input, (byte * ByteSize) + shift, bits);
+        }
+
+        /// the big endian 64 bit word at byte `byte`, with the bytes past the end of `input` read as 0
+        inline uint64_t load_word(span< const byte_type > input, size_type byte) noexcept
+        {
+            if (byte + 8 <= input.size()) {
+                return impl::load_be64(input.data() + byte);
+            }
+            uint64_t w = 0;
+            for (size_type k = 0; k < 8; ++k) {
+                w = (w << ByteSize) | (byte + k < input.size() ? static_cast< uint8_t >(input[byte + k]) : 0U);
+            }
+            return w;
+        }
+
+        /// write the `bits` bit field at bit `shift` of byte `byte`, one 8 byte read-modify-write when the field fits in it
+        inline void write_field(span< byte_type > output, size_type byte, unsigned shift, unsigned bits, uint64_t v) noexcept
+        {
+            if (shift + bits <= 64U && byte + 8 <= output.size()) {
+                const unsigned low = 64U - shift - bits;
+                const uint64_t mask = (bits == 64U ? ~uint64_t{0} : ((uint64_t{1} << bits) - 1)) << low;
+                byte_type *p = output.data() + byte;
+                impl::store_be64(p, (impl::load_be64(p) & ~mask) | ((v << low) & mask));
+                return;
+            }
+            insert< uint64_t >(output, (byte * ByteSize) + shift, bits, bits == 64U ? v : v & ((uint64_t{1} << bits) - 1));
+        }
+
+        /// read the `bits` bit `r`/`t` field at bit `offset` into `out`, laid out like `unpack_bytes_into()` does
+        inline void read_bytes(span< const byte_type > input, const size_type offset, const size_type bits, const bool lsb_first, byte_type *out) noexcept
+        {
+            const size_type full_bytes = bits / ByteSize;
+            const size_type extra_bits = bits % ByteSize;
+            const size_type size = bit2byte(bits);
+            if (full_bytes > 0) {
+                impl::extract_bytes(input, offset, out, full_bytes);
+            }
+            if (extra_bits > 0) {
+                const auto last = extract< uint8_t >(input, offset + (full_bytes * ByteSize), extra_bits);
+                out[size - 1] = static_cast< byte_type >(static_cast< uint8_t >(last << (ByteSize - extra_bits)));
+            }
+            if (lsb_first) {
+                impl::reverse(out, out + size);
+                for (size_type i = 0; i < size; ++i) {
+                    out[i] = impl::reverse_bits< byte_type, ByteSize >(out[i]);
+                }
+            }
+        }
+
+        /// write the `bits` bit `r`/`t` field at bit `offset` from `in`, laid out like `packValue()` does
+        inline void write_bytes(span< byte_type > output, const size_type offset, const size_type bits, const bool lsb_first, const byte_type *in) noexcept
+        {
+            const size_type full_bytes = bits / ByteSize;
+            const size_type extra_bits = bits % ByteSize;
+            const size_type size = bit2byte(bits);
+            if (lsb_first) {
+                // the whole field is bit reversed: byte k of the field is byte `size - 1 - k` of `in`, bit reversed
+                for (size_type k = 0; k < size; ++k) {
+                    const auto b = static_cast< uint8_t >(impl::reverse_bits< byte_type, ByteSize >(in[size - 1 - k]));
+                    if (k < full_bytes) {
+                        insert< uint8_t >(output, offset + (k * ByteSize), ByteSize, b);
+                    }
+                    else {
+                        insert< uint8_t >(output, offset + (k * ByteSize), extra_bits, static_cast< uint8_t >(b >> (ByteSize - extra_bits)));
+                    }
+                }
+                return;
+            }
+            impl::insert_bytes(output, offset, in, full_bytes);
+            if (extra_bits > 0) {
+                const auto last = static_cast< uint8_t >(in[full_bytes]);
+                insert< uint8_t >(output, offset + (full_bytes * ByteSize), extra_bits, static_cast< uint8_t >(last >> (ByteSize - extra_bits)));
+            }
+        }
+
+        /// write the `bits` bit `r`/`t` field `v` to `out`, laid out like `read_bytes()` does
+        inline void field_to_bytes(uint64_t v, const unsigned bits, const bool lsb_first, byte_type *out) noexcept
+        {
+            const auto size = static_cast< unsigned >(bit2byte(bits));
+            const unsigned length = size * ByteSize;
+            v <<= length - bits;  // a partial last byte is left aligned
+            if (lsb_first) {
+                v = impl::reverse_bits64(v) >> (64U - length);
+            }
+            for (unsigned k = 0; k < size; ++k) {
+                out[k] = static_cast< byte_type >(static_cast< uint8_t >(v >> (length - ((k + 1) * ByteSize))));
+            }
+        }
+
+        /// the `bits` bit `r`/`t` field held in `in`, laid out like `write_bytes()` expects
+        inline uint64_t field_from_bytes(const byte_type *in, const unsigned bits, const bool lsb_first) noexcept
+        {
+            const auto size = static_cast< unsigned >(bit2byte(bits));
+            const unsigned length = size * ByteSize;
+            uint64_t v = 0;
+            for (unsigned k = 0; k < size; ++k) {
+                v = (v << ByteSize) | static_cast< uint8_t >(in[k]);
+            }
+            if (lsb_first) {
+                v = impl::reverse_bits64(v) >> (64U - length);
+            }
+            return v >> (length - bits);
+        }
+
+    }  // namespace impl
+
+    /**
+     * A format string parsed at runtime, like `bitstruct.compile()`. The string is parsed once into a list of
+     * operations with their byte index, shift and mask worked out, and `pack`/`unpack` run a short loop over them.
+     * Supports every item type, both bit orders, `[N]` arrays and a trailing `>` or `<` byte order. Every non-padding
+     * value (and every element of an array) is passed as a `uint64_t`:
+     *  - `u` and `b` values as is, `s` values sign extended so they can be cast to `int64_t`
+     *  - `f` values (16, 32 or 64 bits) as the bit pattern of a `double`, see `from_double()` and `to_double()`
+     *  - `r` and `t` fields are copied to or from a separate byte span, each taking `bit2byte(bits)` bytes in format
+     *    order. Their value is the index of the field's first byte in that span.
+     * With little endian byte order the bytes of each value are swapped, so values over 8 bits must be a whole number
+     * of bytes, and `r`/`t` items are not supported.
+     */
+    class compiled_format {
+    public:
+        compiled_format() noexcept = default;
+
+        /**
+         * Parse the format string `fmt`. Use `valid()` to check the result.
+         * @param fmt [IN] format string, with the same syntax as `BP_STRING()`
+         */
+        explicit compiled_format(std::string_view fmt)
+        {
+            bool byte_swap = false;
+            if (!fmt.empty() && fmt.back() == '<') {
+                byte_swap = true;
+                fmt.remove_suffix(1);
+            }
+
+            size_type pos = 0;
+            size_type offset = 0;
+            auto endian = impl::Endian::big;
+            impl::RawFormatType item{};
+            for (;;) {
+                const auto result = impl::parse_item(fmt, pos, endian, item);
+                if (result == impl::parse_result::end) {
+                    break;
+                }
+                const auto bits = result == impl::parse_result::item ? impl::element_bits(item) : 0;
+                if (result == impl::parse_result::error || !supported(item.formatChar, bits, byte_swap)) {
+                    m_items.clear();
+                    m_ops.clear();
+                    m_fields = 0;
+                    m_data_bytes = 0;
+                    return;
+                }
+                item.offset = offset;
+                m_items.push_back(item);
+                const size_type elements = item.repeat != 0 ? item.repeat : 1;
+                for (size_type e = 0; e < elements; ++e, offset += bits) {
+                    auto op = make_op(item.formatChar, offset, bits, item.endian == impl::Endian::little, byte_swap);
+                    if (op.kind == impl::compiled_op::bytes) {
+                        op.data = m_data_bytes;
+                        m_data_bytes += impl::bit2byte(bits);
+                    }
+                    m_ops.push_back(op);
+                    m_fields += impl::isPadding(item.formatChar) ? 0 : 1;
+                }
+            }
+            m_bits = offset;
+            m_valid = true;
+            group_words();
+        }
+
+        /// true if the format string was parsed and is supported
+        bool valid() const noexcept { return m_valid; }
+        /// the number of bits in the format, like `calcsize()`
+        size_type size() const noexcept { return m_bits; }
+        /// the number of bytes needed to hold the format, like `calcbytes()`
+        size_type bytes() const noexcept { return impl::bit2byte(m_bits); }
+        /// the number of values to pack or unpack: one per non-padding item, or array element
+        size_type field_count() const noexcept { return m_fields; }
+        /// the number of bytes the `r` and `t` fields take in the byte span passed to `pack`/`unpack`
+        size_type data_bytes() const noexcept { return m_data_bytes; }
+        /// the parsed items, laid out like the result of `impl::get_type_array()`
+        span< const impl::RawFormatType > items() const noexcept { return {m_items.data(), m_items.size()}; }
+
+        /// the value to pass for an `f` field
+        static uint64_t from_double(const double value) noexcept
+        {
+            uint64_t result = 0;
+            std::memcpy(&result, &value, sizeof(result));
+            return result;
+        }
+
+        /// the number held by the unpacked value of an `f` field
+        static double to_double(const uint64_t value) noexcept
+        {
+            double result = 0;
+            std::memcpy(&result, &value, sizeof(result));
+            return result;
+        }
+
+        /**
+         * Unpack the values of the format from `packedInput` starting at bit `offset`.
+         * @param packedInput [IN] span of bytes to unpack
+         * @param offset [IN] bit index to start unpacking from
+         * @param values [OUT] receives one value per non-padding field, must hold at least `field_count()` values
+         * @param data [OUT] receives the `r` and `t` fields, must hold at least `data_bytes()` bytes
+         * @return false, and nothing is unpacked, if the format is not valid or any span is too small
+         */
+        bool unpack_from(span< const byte_type > packedInput, const size_type offset, span< uint64_t > values, span< byte_type > data) const noexcept
+        {
+            if (!m_valid || values.size() < m_fields || data.size() < m_data_bytes || packedInput.size() * ByteSize < offset + m_bits) {
+                return false;
+            }
+            const auto base = impl::get_offset(offset);
+            uint64_t *out = values.data();
+            byte_type *bytes = data.data();
+            const impl::compiled_op *op = m_ops.data();
+            if (base.bit != 0) {
+                for (const impl::compiled_op *last = op + m_ops.size(); op != last; ++op) {
+                    read_op(*op, packedInput, offset, out, bytes);
+                }
+                return true;
+            }
+            // byte aligned: each word is loaded once and its fields are shifted out of it
+            const auto input = packedInput.subspan(base.byte);
+            for (const auto &word : m_words) {
+                if (word.mask == 0) {
+                    read_op(*op++, packedInput, offset, out, bytes);
+                    continue;
+                }
+                const uint64_t w = impl::load_word(input, word.byte);
+                for (const impl::compiled_op *last = op + word.ops; op != last; ++op) {
+                    if (op->kind >= impl::compiled_op::zeros) {
+                        continue;
+                    }
+                    const auto v = (w << op->window) >> (64U - op->bits);
+                    *out++ = op->plain ? (v ^ op->sign) - op->sign : finish(*op, v, bytes);
+                }
+            }
+            return true;
+        }
+
+        /// Unpack a format without `r` or `t` items from `packedInput` starting at bit `offset`. See `unpack_from()`.
+        bool unpack_from(span< const byte_type > packedInput, const size_type offset, span< uint64_t > values) const noexcept
+        {
+            return unpack_from(packedInput, offset, values, span< byte_type >());
+        }
+
+        /// Unpack the values of the format from the start of `packedInput`. See `unpack_from()`.
+        bool unpack(span< const byte_type > packedInput, span< uint64_t > values, span< byte_type > data) const noexcept
+        {
+            return unpack_from(packedInput, 0, values, data);
+        }
+
+        /// Unpack a format without `r` or `t` items from the start of `packedInput`. See `unpack_from()`.
+        bool unpack(span< const byte_type > packedInput, span< uint64_t > values) const noexcept
+        {
+            return unpack_from(packedInput, 0, values, span< byte_type >());
+        }
+
+        /**
+         * Pack `values` into `output` starting at bit `offset`. Padding is always written.
+         * @param output [OUT] span of bytes to pack into
+         * @param offset [IN] bit index to start packing at
+         * @param values [IN] one value per non-padding field, at least `field_count()` values. The values of `r` and
+         *               `t` fields are ignored.
+         * @param data [IN] the `r` and `t` fields, at least `data_bytes()` bytes
+         * @return false, and nothing is packed, if the format is not valid or any span is too small
+         */
+        bool pack_into(span< byte_type > output, const size_type offset, span< const uint64_t > values, span< const byte_type > data) const noexcept
+        {
+            if (!m_valid || values.size() < m_fields || data.size() < m_data_bytes || output.size() * ByteSize < offset + m_bits) {
+                return false;
+            }
+            const auto base = impl::get_offset(offset);
+            const uint64_t *in = values.data();
+            const byte_type *bytes = data.data();
+            const impl::compiled_op *op = m_ops.data();
+            if (base.bit != 0) {
+                for (const impl::compiled_op *last = op + m_ops.size(); op != last; ++op) {
+                    write_op(*op, output, offset, in, bytes);
+                }
+                return true;
+            }
+            // byte aligned: each word is built in a register and written once
+            const auto available = output.size() - base.byte;
+            byte_type *out = output.data() + base.byte;
+            for (const auto &word : m_words) {
+                if (word.mask == 0) {
+                    write_op(*op++, output, offset, in, bytes);
+                    continue;
+                }
+                uint64_t w = word.fill;
+                for (const impl::compiled_op *last = op + word.ops; op != last; ++op) {
+                    if (op->kind >= impl::compiled_op::zeros) {
+                        continue;
+                    }
+                    const auto v = op->plain ? *in++ : prepare(*op, in, bytes);
+                    w |= (v << (64U - op->bits)) >> op->window;
+                }
+                byte_type *p = out + word.byte;
+                if (word.byte + 8 <= available) {
+                    impl::store_be64(p, (impl::load_be64(p) & ~word.mask) | w);
+                    continue;
+                }
+                // the buffer ends inside the last word, the mask is clear past the end of the format
+                for (size_type k = 0; word.byte + k < available; ++k) {
+                    const auto mask = static_cast< uint8_t >(word.mask >> (56U - (k * ByteSize)));
+                    const auto bits = static_cast< uint8_t >(w >> (56U - (k * ByteSize)));
+                    p[k] = static_cast< byte_type >((static_cast< uint8_t >(p[k]) & static_cast< uint8_t >(~mask)) | bits);
+                }
+            }
+            return true;
+        }
+
+        /// Pack `values` of a format without `r` or `t` items into `output` starting at bit `offset`. See `pack_into()`.
+        bool pack_into(span< byte_type > output, const size_type offset, span< const uint64_t > values) const noexcept
+        {
+            return pack_into(output, offset, values, span< const byte_type >());
+        }
+
+        /// Pack `values` at the start of `output`. See `pack_into()`.
+        bool pack(span< byte_type > output, span< const uint64_t > values, span< const byte_type > data) const noexcept
+        {
+            return pack_into(output, 0, values, data);
+        }
+
+        /// Pack `values` of a format without `r` or `t` items at the start of `output`. See `pack_into()`.
+        bool pack(span< byte_type > output, span< const uint64_t > values) const noexcept
+        {
+            return pack_into(output, 0, values, span< const byte_type >());
+        }
+
+    private:
+        /// true if an item of type `type` with `bits` bit elements can be compiled
+        static bool supported(const char type, const size_type bits, const bool byte_swap) noexcept
+        {
+            if (impl::isByteType(type)) {
+                return !byte_swap;
+            }
+            if (type == 'f') {
+                return bits == 16 || bits == 32 || bits == 64;
+            }
+            return bits <= 64 && (!byte_swap || bits <= ByteSize || bits % ByteSize == 0);
+        }
+
+        /// unpack the field of `op` on its own, for fields that aren't in an 8 byte word
+        static void read_op(const impl::compiled_op &op, span< const byte_type > input, const size_type offset, uint64_t *&out, byte_type *data) noexcept
+        {
+            if (op.kind >= impl::compiled_op::zeros) {
+                return;
+            }
+            if (op.bits == 0) {
+                impl::read_bytes(input, offset + op.bit, op.data_bits, op.lsb_first, data + op.data);
+                *out++ = op.data;
+                return;
+            }
+            const auto at = impl::get_offset(offset + op.bit);
+            *out++ = finish(op, impl::read_field(input, at.byte, static_cast< unsigned >(at.bit), op.bits), data);
+        }
+
+        /// pack the field of `op` on its own, for fields that aren't in an 8 byte word
+        static void write_op(const impl::compiled_op &op, span< byte_type > output, const size_type offset, const uint64_t *&in, const byte_type *data) noexcept
+        {
+            if (op.bits == 0) {
+                impl::write_bytes(output, offset + op.bit, op.data_bits, op.lsb_first, data + op.data);
+                ++in;
+                return;
+            }
+            const auto at = impl::get_offset(offset + op.bit);
+            impl::write_field(output, at.byte, static_cast< unsigned >(at.bit), op.bits, prepare(op, in, data));
+        }
+
+        /// the raw field for `op`, taking its value from `in` and moving `in` past it unless `op` is padding
+        static uint64_t prepare(const impl::compiled_op &op, const uint64_t *&in, const byte_type *data) noexcept
+        {
+            uint64_t v = 0;
+            switch (op.kind) {
+            case impl::compiled_op::zeros: return 0;
+            case impl::compiled_op::ones: return ~uint64_t{0};
+            case impl::compiled_op::bytes: ++in; return impl::field_from_bytes(data + op.data, op.bits, op.lsb_first);
+            case impl::compiled_op::boolean: v = *in++ != 0 ? 1 : 0; break;
+            case impl::compiled_op::floating: v = impl::double_to_float_bits(*in++, op.bits); break;
+            default: v = *in++; break;
+            }
+            if (op.lsb_first) {
+                v = impl::reverse_bits64(v) >> (64U - op.bits);
+            }
+            if (op.swap) {
+                v = impl::byte_swap64(v) >> (64U - op.bits);
+            }
+            return v;
+        }
+
+        /// apply the byte order, bit order and type of `op` to the raw field `v`
+        static uint64_t finish(const impl::compiled_op &op, uint64_t v, byte_type *data) noexcept
+        {
+            if (op.kind == impl::compiled_op::bytes) {
+                impl::field_to_bytes(v, op.bits, op.lsb_first, data + op.data);
+                return op.data;
+            }
+            if (op.swap) {
+                v = impl::byte_swap64(v) >> (64U - op.bits);
+            }
+            if (op.lsb_first) {
+                v = impl::reverse_bits64(v) >> (64U - op.bits);
+            }
+            v = (v ^ op.sign) - op.sign;
+            if (op.kind == impl::compiled_op::boolean) {
+                v = v != 0 ? 1 : 0;
+            }
+            else if (op.kind == impl::compiled_op::floating) {
+                v = impl::float_bits_to_double(v, op.bits);
+            }
+            return v;
+        }
+
+        static impl::compiled_op make_op(const char type, const size_type bit, const size_type bits, const bool lsb_first, const bool byte_swap) noexcept
+        {
+            impl::compiled_op op{};
+            const auto at = impl::get_offset(bit);
+            op.bit = bit;
+            op.byte = at.byte;
+            op.shift = static_cast< uint8_t >(at.bit);
+            op.lsb_first = lsb_first;
+            if (impl::isByteType(type)) {
+                // up to 64 bits are shifted in and out of a word like an integer, longer fields use the byte kernels
+                op.kind = impl::compiled_op::bytes;
+                op.data_bits = bits;
+                op.bits = static_cast< uint8_t >(bits <= 64 ? bits : 0);
+                op.fits = bits <= 64 && at.bit + bits <= 64;
+                return op;
+            }
+            op.bits = static_cast< uint8_t >(bits);
+            op.fits = at.bit + bits <= 64;
+            op.swap = byte_swap && bits > ByteSize;
+            switch (type) {
+            case 's':
+                op.kind = impl::compiled_op::signed_int;
+                op.sign = bits < 64 ? uint64_t{1} << (bits - 1U) : 0;
+                break;
+            case 'b': op.kind = impl::compiled_op::boolean; break;
+            case 'f': op.kind = impl::compiled_op::floating; break;
+            case 'p': op.kind = impl::compiled_op::zeros; break;
+            case 'P': op.kind = impl::compiled_op::ones; break;
+            default: op.kind = impl::compiled_op::unsigned_int; break;
+            }
+            op.plain = (op.kind == impl::compiled_op::unsigned_int || op.kind == impl::compiled_op::signed_int) && !lsb_first && !op.swap;
+            return op;
+        }
+
+        /// group consecutive ops into the fewest 8 byte words, for packing and unpacking at a byte aligned offset
+        void group_words()
+        {
+            bool open = false;
+            for (auto &op : m_ops) {
+                if (!op.fits) {
+                    m_words.push_back({op.byte, 1, 0, 0});
+                    open = false;
+                    continue;
+                }
+                if (!open || op.bit + op.bits > (m_words.back().byte * ByteSize) + 64) {
+                    m_words.push_back({op.byte, 0, 0, 0});
+                    open = true;
+                }
+                auto &word = m_words.back();
+                op.window = static_cast< uint8_t >(op.bit - (word.byte * ByteSize));
+                const uint64_t bits = (op.bits == 64 ? ~uint64_t{0} : ((uint64_t{1} << op.bits) - 1)) << (64U - op.window - op.bits);
+                word.mask |= bits;
+                word.fill |= op.kind == impl::compiled_op::ones ? bits : 0;
+                ++word.ops;
+            }
+        }
+
+        std::vector< impl::RawFormatType > m_items;
+        std::vector< impl::compiled_op > m_ops;        //< every item, in order
+        std::vector< impl::compiled_word > m_words;    //< `m_ops` grouped into 8 byte words
+        size_type m_fields = 0;                        //< number of non-padding ops
+        size_type m_bits = 0;
+        size_type m_data_bytes = 0;                    //< bytes taken by the `r` and `t` fields in the byte span
+        bool m_valid = false;
+    };
+
+    /**
+     * Parse a format string at runtime, see `compiled_format`.
+     * @param fmt [IN] format string, with the same syntax as `BP_STRING()`
+     * @return the compiled format, check `valid()` before using it
+     */
+    inline compiled_format compile(std::string_view fmt)
+    {
+        return compiled_format(fmt);
+    }
+
+    /**
+     * A thread-safe, bounded cache of compiled formats, for format strings that show up again and again at runtime.
+     * Each distinct string is parsed once; when the cache is full the least recently used format is dropped.
+     * Formats are handed out as `shared_ptr`s, so a format stays usable after it is dropped from the cache.
+     */
+    class format_cache {
+    public:
+        using format_ptr = std::shared_ptr< const compiled_format >;
+
+        /// hit and miss counts since construction or the last `clear()`
+        struct statistics {
+            size_type hits;
+            size_type misses;
+            size_type size;     //< number of formats in the cache
+        };
+
+        /// @param capacity [IN] maximum number of formats to keep, at least 1
+        explicit format_cache(const size_type capacity = 64)
+            : m_capacity(capacity != 0 ? capacity : 1)
+        {}
+
+        format_cache(const format_cache &) = delete;
+        format_cache &operator=(const format_cache &) = delete;
+
+        /**
+         * Get the compiled form of `fmt`, parsing it only if it is not in the cache. Invalid formats are cached too,
+         * check `valid()` on the result.
+         * @param fmt [IN] format string, with the same syntax as `BP_STRING()`
+         */
+        format_ptr get(std::string_view fmt)
+        {
+            {
+                std::lock_guard< std::mutex > lock(m_mutex);
+                if (auto found = m_index.find(fmt); found != m_index.end()) {
+                    ++m_hits;
+                    m_entries.splice(m_entries.begin(), m_entries, found->second);
+                    return found->second->second;
+                }
+                ++m_misses;
+            }
+
+            // parse without holding the lock, another thread may add the same format meanwhile
+            auto compiled = std::make_shared< const compiled_format >(fmt);
+
+            std::lock_guard< std::mutex > lock(m_mutex);
+            if (auto found = m_index.find(fmt); found != m_index.end()) {
+                m_entries.splice(m_entries.begin(), m_entries, found->second);
+                return found->second->second;
+            }
+            if (m_entries.size() == m_capacity) {
+                m_index.erase(m_entries.back().first);
+                m_entries.pop_back();
+            }
+            m_entries.emplace_front(std::string(fmt), compiled);
+            // the key views the string in the list node, which doesn't move until the entry is erased
+            m_index.emplace(m_entries.front().first, m_entries.begin());
+            return compiled;
+        }
+
+        /// the hit and miss counts and current size
+        statistics stats() const
+        {
+            std::lock_guard< std::mutex > lock(m_mutex);
+            return {m_hits, m_misses, m_entries.size()};
+        }
+
+        /// the maximum number of formats kept
+        size_type capacity() const noexcept { return m_capacity; }
+
+        /// drop every format and reset the counts
+        void clear()
+        {
+            std::lock_guard< std::mutex > lock(m_mutex);
+            m_index.clear();
+            m_entries.clear();
+            m_hits = 0;
+            m_misses = 0;
+        }
+
+    private:
+        using entry_list = std::list< std::pair< std::string, format_ptr > >;
+
+        mutable std::mutex m_mutex;
+        entry_list m_entries;   //< most recently used first
+        std::unordered_map< std::string_view, entry_list::iterator > m_index;
+        size_type m_capacity;
+        size_type m_hits = 0;
+        size_type m_misses = 0;
+    };
+
+}  // namespace bitpacker
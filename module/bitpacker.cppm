@@ -0,0 +1,103 @@
+/**
+ *  BITPACKER
+ *  type-safe and low boilerplate bit-level serialization
+ *  https://github.com/CrustyAuklet/bitpacker
+ *
+ *  Copyright 2020 Ethan Slattery
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+// C++20 module interface unit for bitpacker: `import bitpacker;` instead of including the headers.
+// Macros can't be exported, so formats are written as `bitpacker::fmt<"u12b1">` or `"u12b1"_bpf` instead of BP_STRING().
+module;
+
+#include "bitpacker/bitpacker.hpp"
+#include "bitpacker/parallel.hpp"
+#include "bitpacker/runtime.hpp"
+
+export module bitpacker;
+
+export namespace bitpacker {
+    // low level interface (core.hpp)
+    using bitpacker::byte_type;
+    using bitpacker::size_type;
+    using bitpacker::ByteSize;
+    using bitpacker::span;
+    using bitpacker::insert;
+    using bitpacker::extract;
+    using bitpacker::get;
+    using bitpacker::store;
+
+    // format strings
+    using bitpacker::fmt;
+    using bitpacker::calcsize;
+    using bitpacker::calcbytes;
+    using bitpacker::concat;
+    using bitpacker::format_binding;
+
+    // pack and unpack
+    using bitpacker::unpack;
+    using bitpacker::unpack_from;
+    using bitpacker::unpack_into;
+    using bitpacker::unpack_from_into;
+    using bitpacker::unpack_result_t;
+    using bitpacker::large_record;
+    using bitpacker::pack;
+    using bitpacker::pack_into;
+    using bitpacker::packed_size;
+    using bitpacker::unpack_counted;
+    using bitpacker::unpack_counted_from;
+    using bitpacker::pack_counted_into;
+    using bitpacker::unpack_optional;
+    using bitpacker::unpack_optional_from;
+    using bitpacker::pack_optional_into;
+
+    // batches of records
+    using bitpacker::pack_columns;
+    using bitpacker::pack_batch;
+    using bitpacker::unpack_batch;
+    using bitpacker::unpack_columns;
+    using bitpacker::parallel_pack_batch;
+    using bitpacker::parallel_pack_columns;
+    using bitpacker::parallel_unpack_batch;
+    using bitpacker::parallel_unpack_columns;
+
+    // views
+    using bitpacker::format_view;
+    using bitpacker::view;
+    using bitpacker::const_field_ref;
+    using bitpacker::field_ref;
+    using bitpacker::mutable_format_view;
+    using bitpacker::mutable_view;
+    using bitpacker::record_view;
+    using bitpacker::records;
+
+    // tagged unions and message registries
+    using bitpacker::tagged_format;
+    using bitpacker::alternative;
+    using bitpacker::tagged;
+    using bitpacker::unpack_variant;
+    using bitpacker::unpack_variant_from;
+    using bitpacker::pack_variant;
+    using bitpacker::pack_variant_into;
+    using bitpacker::message_registry;
+    using bitpacker::message;
+    using bitpacker::registry;
+
+    // message templates
+    using bitpacker::hole_t;
+    using bitpacker::hole;
+    using bitpacker::message_template;
+    using bitpacker::prebake;
+
+    // formats parsed at runtime (runtime.hpp)
+    using bitpacker::compiled_format;
+    using bitpacker::compile;
+    using bitpacker::format_cache;
+
+    namespace literals {
+        using bitpacker::literals::operator""_bpf;
+    }
+}  // namespace bitpacker
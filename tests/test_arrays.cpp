@@ -0,0 +1,49 @@
+#include "test_common.hpp"
+#include "constexpr_helpers.h"
+#include <array>
+
+TEST_CASE("array items pack like repeated items", "[bitpacker::arrays]")
+{
+    constexpr auto array_fmt = BP_STRING("u4u12[5]<s7[3]p2[2]b1");
+    constexpr auto flat_fmt = BP_STRING("u4u12u12u12u12u12<s7s7s7p2p2b1");
+    const std::array< uint16_t, 5 > values{0x123, 0xFFF, 0x000, 0xABC, 0x801};
+    const std::array< int8_t, 3 > signed_values{-64, 63, -1};
+
+    const auto array_packed = bitpacker::pack(array_fmt, 0x9, values, signed_values, true);
+    const auto flat_packed = bitpacker::pack(flat_fmt, 0x9, values[0], values[1], values[2], values[3], values[4],
+                                             signed_values[0], signed_values[1], signed_values[2], true);
+    REQUIRE(array_packed == flat_packed);
+
+    const auto unpacked = bitpacker::unpack(array_fmt, array_packed);
+    REQUIRE(std::get< 0 >(unpacked) == 0x9);
+    REQUIRE(std::get< 1 >(unpacked) == values);
+    REQUIRE(std::get< 2 >(unpacked) == signed_values);
+    REQUIRE(std::get< 3 >(unpacked) == true);
+}
+
+TEST_CASE("array of raw items", "[bitpacker::arrays]")
+{
+    constexpr auto array_fmt = BP_STRING("u3r12[2]");
+    constexpr auto flat_fmt = BP_STRING("u3r12r12");
+    const std::array< std::array< uint8_t, 2 >, 2 > raw{{{0xAB, 0xC0}, {0x12, 0x30}}};
+
+    const auto array_packed = bitpacker::pack(array_fmt, 5, raw);
+    REQUIRE(array_packed == bitpacker::pack(flat_fmt, 5, raw[0], raw[1]));
+    REQUIRE(std::get< 1 >(bitpacker::unpack(array_fmt, array_packed)) == raw);
+}
+
+TEST_CASE("array items unpack into caller storage", "[bitpacker::arrays]")
+{
+    constexpr auto fmt = BP_STRING("u12[4]b1");
+    const std::array< uint16_t, 4 > values{1, 2, 0x400, 0xFFF};
+    const auto packed = bitpacker::pack(fmt, values, false);
+
+    uint32_t out[4] = {};
+    bool flag = true;
+    bitpacker::unpack_into(fmt, packed, out, flag);
+    REQUIRE(out[0] == 1);
+    REQUIRE(out[1] == 2);
+    REQUIRE(out[2] == 0x400);
+    REQUIRE(out[3] == 0xFFF);
+    REQUIRE(flag == false);
+}
@@ -0,0 +1,145 @@
+#include "test_common.hpp"
+#include <array>
+#include <vector>
+#include <algorithm>
+
+namespace {
+    template < typename Fmt, size_t N, typename... Columns >
+    std::array< uint8_t, N > pack_rows(Fmt fmt, const size_t count, const Columns &... columns)
+    {
+        std::array< uint8_t, N > expected{};
+        for (size_t r = 0; r < count; ++r) {
+            bitpacker::pack_into(fmt, expected, r * bitpacker::calcsize(fmt), columns[r]...);
+        }
+        return expected;
+    }
+}
+
+TEST_CASE("pack columns with byte aligned records", "[bitpacker::batch]")
+{
+    constexpr auto fmt = BP_STRING("u4P4s12p4");
+    const std::array< uint8_t, 5 > a{1, 2, 3, 15, 0};
+    const std::vector< int16_t > b{-1, 2047, -2048, 0, 100};
+
+    std::array< uint8_t, 15 > packed{};
+    bitpacker::pack_columns(fmt, packed, 5, a, b);
+
+    REQUIRE(packed == pack_rows< decltype(fmt), 15 >(fmt, 5, a, b));
+}
+
+TEST_CASE("pack columns with bit-dense records", "[bitpacker::batch]")
+{
+    // 13 bit records: neighboring records share bytes
+    constexpr auto fmt = BP_STRING("u5P3<s5");
+    const std::array< uint8_t, 7 > a{31, 0, 7, 16, 1, 30, 12};
+    const std::array< int8_t, 7 > b{-16, 15, 0, -1, 3, -7, 9};
+
+    std::array< uint8_t, 12 > packed{};
+    packed.fill(0xA5);
+    bitpacker::pack_columns(fmt, packed, 7, a, b);
+
+    // bits after the last record are not modified
+    auto expected = pack_rows< decltype(fmt), 12 >(fmt, 7, a, b);
+    expected[11] = static_cast< uint8_t >((expected[11] & 0xE0U) | (0xA5U & 0x1FU));
+    REQUIRE(packed == expected);
+}
+
+TEST_CASE("pack columns with raw fields", "[bitpacker::batch]")
+{
+    constexpr auto fmt = BP_STRING("b1r12p3");
+    const std::array< bool, 3 > flags{true, false, true};
+    const std::array< std::array< uint8_t, 2 >, 3 > raw{{{0xAB, 0xC0}, {0x12, 0x30}, {0xFF, 0xF0}}};
+
+    std::array< uint8_t, 6 > packed{};
+    bitpacker::pack_columns(fmt, packed, 3, flags, raw);
+
+    REQUIRE(packed == pack_rows< decltype(fmt), 6 >(fmt, 3, flags, raw));
+}
+
+TEST_CASE("raw and text fields with a partial last byte", "[bitpacker::batch]")
+{
+    // only the upper bits of the last byte belong to the field, the bits after it are left alone
+    std::array< uint8_t, 2 > packed{0xFF, 0xFF};
+    bitpacker::pack_into(BP_STRING("r12"), packed, 0, std::array< uint8_t, 2 >{0xAB, 0xCD});
+    REQUIRE(packed == std::array< uint8_t, 2 >{0xAB, 0xCF});
+
+    packed = {0xFF, 0xFF};
+    bitpacker::pack_into(BP_STRING("t12"), packed, 0, "hi");
+    REQUIRE(packed == std::array< uint8_t, 2 >{0x68, 0x6F});
+
+    packed = {0x00, 0x00};
+    bitpacker::pack_into(BP_STRING("r4"), packed, 2, std::array< uint8_t, 1 >{0xA5});
+    REQUIRE(packed == std::array< uint8_t, 2 >{0x28, 0x00});
+
+    // a field ending at the end of the buffer writes nothing past it
+    constexpr auto raw12 = BP_STRING("r12");
+    using field = bitpacker::impl::field_type< std::remove_const_t< decltype(raw12) >, 0 >;
+    std::array< uint8_t, 3 > guarded{0x00, 0x00, 0x77};
+    bitpacker::impl::packElement< field >(bitpacker::span< uint8_t >(guarded.data(), 2), 4, std::array< uint8_t, 2 >{0xAB, 0xCD});
+    REQUIRE(guarded == std::array< uint8_t, 3 >{0x0A, 0xBC, 0x77});
+}
+
+TEST_CASE("batch functions check sizes", "[bitpacker::batch]")
+{
+    constexpr auto fmt = BP_STRING("u5P3<s5");  // 13 bits, 3 records need 5 bytes
+    const std::array< uint8_t, 3 > a{1, 2, 3};
+    const std::array< int8_t, 3 > b{-1, -2, -3};
+    const std::array< int8_t, 2 > short_b{-1, -2};
+
+    std::array< uint8_t, 4 > small{};
+    REQUIRE_FALSE(bitpacker::pack_columns(fmt, small, 3, a, b));
+    REQUIRE(small == std::array< uint8_t, 4 >{});
+    std::array< uint8_t, 5 > packed{};
+    REQUIRE_FALSE(bitpacker::pack_columns(fmt, packed, 3, a, short_b));
+    REQUIRE(packed == std::array< uint8_t, 5 >{});
+    REQUIRE(bitpacker::pack_columns(fmt, packed, 3, a, b));
+
+    std::vector< bitpacker::unpack_result_t< decltype(fmt) > > records(2);
+    REQUIRE_FALSE(bitpacker::unpack_batch(fmt, packed, 3, records));
+    REQUIRE_FALSE(bitpacker::pack_batch(fmt, packed, 3, records));
+    records.resize(3);
+    REQUIRE_FALSE(bitpacker::unpack_batch(fmt, small, 3, records));
+    REQUIRE(bitpacker::unpack_batch(fmt, packed, 3, records));
+    REQUIRE(std::get< 1 >(records[2]) == -3);
+    REQUIRE(bitpacker::pack_batch(fmt, packed, 3, records));
+
+    std::array< uint8_t, 3 > a_out{};
+    std::array< int8_t, 2 > b_out{};
+    REQUIRE_FALSE(bitpacker::unpack_columns(fmt, packed, 3, a_out, b_out));
+    REQUIRE(a_out == std::array< uint8_t, 3 >{});
+    REQUIRE(bitpacker::unpack_columns(fmt, packed, 2, a_out, b_out));
+    REQUIRE(b_out == short_b);
+}
+
+TEST_CASE("record view over bit-dense records", "[bitpacker::records]")
+{
+    constexpr auto fmt = BP_STRING("u5P3<s5");
+    const std::array< uint8_t, 7 > a{31, 0, 7, 16, 1, 30, 12};
+    const std::array< int8_t, 7 > b{-16, 15, 0, -1, 3, -7, 9};
+    std::array< uint8_t, 12 > packed{};
+    bitpacker::pack_columns(fmt, packed, 7, a, b);
+
+    const auto recs = bitpacker::records(fmt, packed);
+    REQUIRE(recs.size() == 7);
+    REQUIRE(std::distance(recs.begin(), recs.end()) == 7);
+    for (size_t i = 0; i < recs.size(); ++i) {
+        REQUIRE(recs[i] == std::make_tuple(a[i], b[i]));
+    }
+    REQUIRE(recs.back() == std::make_tuple(a[6], b[6]));
+
+    const auto found = std::find_if(recs.begin(), recs.end(), [](const auto &r) { return std::get< 1 >(r) == -1; });
+    REQUIRE(found - recs.begin() == 3);
+    REQUIRE(std::get< 0 >(*found) == 16);
+
+    // records after a bit offset, with prefetching while iterating
+    const auto from_second = bitpacker::records(fmt, packed, 13, 2);
+    REQUIRE(from_second.size() == 6);
+    size_t idx = 1;
+    for (const auto r : from_second) {
+        REQUIRE(r == std::make_tuple(a[idx], b[idx]));
+        ++idx;
+    }
+    REQUIRE(idx == 7);
+
+    REQUIRE(bitpacker::records(fmt, bitpacker::span< const uint8_t >(packed.data(), 1)).empty());
+}
@@ -0,0 +1,100 @@
+#include "test_common.hpp"
+#include "constexpr_helpers.h"
+#include <array>
+#include <vector>
+
+TEST_CASE("parse counted array items", "[bitpacker::counted]")
+{
+    namespace bpimpl = bitpacker::impl;
+    constexpr auto fmt = BP_STRING("u8p2b1s14[#0]");
+    REQUIRE_STATIC(bpimpl::validate_format(fmt));
+    REQUIRE_STATIC(!bpimpl::validate_format(BP_STRING("u8s14[#]")));
+    REQUIRE_STATIC(bpimpl::count_non_padding(fmt) == 3);
+    REQUIRE_STATIC(bpimpl::get_type_array(fmt)[3].counted);
+    REQUIRE_STATIC(bpimpl::get_type_array(fmt)[3].count_field == 0);
+    REQUIRE_STATIC(bpimpl::get_type_array(fmt)[3].count == 14);
+    REQUIRE_STATIC(bpimpl::valid_counted_format(fmt));
+    REQUIRE_STATIC(!bpimpl::valid_counted_format(BP_STRING("s8s14[#0]")));
+    REQUIRE_STATIC(!bpimpl::valid_counted_format(BP_STRING("u8s14[#0]b1")));
+    REQUIRE_STATIC(bitpacker::calcsize(fmt) == 11);
+    REQUIRE_STATIC(bitpacker::packed_size(fmt, 3) == 11 + (3 * 14));
+}
+
+TEST_CASE("pack and unpack counted arrays", "[bitpacker::counted]")
+{
+    constexpr auto fmt = BP_STRING("u8p2b1s14[#0]");
+    const std::array< int16_t, 5 > values{-8192, 8191, 0, -1, 1234};
+    std::array< uint8_t, 16 > packed{};
+    REQUIRE(bitpacker::pack_counted_into(fmt, packed, 0, 4, true, values));
+
+    // same bits as the equivalent fixed format
+    const auto fixed = bitpacker::pack(BP_STRING("u8p2b1s14s14s14s14"), 4, true, values[0], values[1], values[2], values[3]);
+    REQUIRE(std::equal(fixed.begin(), fixed.end(), packed.begin()));
+
+    uint8_t count = 0;
+    bool flag = false;
+    std::vector< int32_t > out(8, 99);
+    REQUIRE(bitpacker::unpack_counted(fmt, packed, count, flag, out));
+    REQUIRE(count == 4);
+    REQUIRE(flag == true);
+    REQUIRE(out == std::vector< int32_t >{-8192, 8191, 0, -1, 99, 99, 99, 99});
+}
+
+TEST_CASE("counted array sizes are validated", "[bitpacker::counted]")
+{
+    constexpr auto fmt = BP_STRING("u4u12[#0]");
+    const std::array< uint16_t, 3 > values{1, 2, 3};
+    std::array< uint8_t, 4 > small{};
+    REQUIRE_FALSE(bitpacker::pack_counted_into(fmt, small, 0, 3, values)); // needs 40 bits
+    REQUIRE_FALSE(bitpacker::pack_counted_into(fmt, small, 0, 4, values)); // more than given
+    REQUIRE(bitpacker::pack_counted_into(fmt, small, 0, 2, values));
+
+    uint8_t count = 0;
+    std::array< uint16_t, 1 > too_small{};
+    REQUIRE_FALSE(bitpacker::unpack_counted(fmt, small, count, too_small));
+    REQUIRE(count == 0); // nothing is written on failure
+
+    const std::array< uint8_t, 3 > truncated{0xF0, 0x00, 0x00};
+    std::array< uint16_t, 16 > out{};
+    REQUIRE_FALSE(bitpacker::unpack_counted(fmt, truncated, count, out));
+
+    std::array< uint16_t, 2 > exact{};
+    REQUIRE(bitpacker::unpack_counted(fmt, small, count, exact));
+    REQUIRE(count == 2);
+    REQUIRE(exact == std::array< uint16_t, 2 >{1, 2});
+}
+
+TEST_CASE("counts that don't fit the count field are rejected", "[bitpacker::counted]")
+{
+    constexpr auto fmt = BP_STRING("u2s8[#0]");
+    const std::array< int8_t, 5 > values{1, -2, 3, -4, 5};
+    std::array< uint8_t, 8 > packed{};
+    REQUIRE_FALSE(bitpacker::pack_counted_into(fmt, packed, 0, 5, values));
+    REQUIRE_FALSE(bitpacker::pack_counted_into(fmt, packed, 0, 4, values));
+    REQUIRE(packed == std::array< uint8_t, 8 >{});
+    REQUIRE(bitpacker::pack_counted_into(fmt, packed, 0, 3, values));
+
+    uint8_t count = 0;
+    std::array< int8_t, 5 > out{};
+    REQUIRE(bitpacker::unpack_counted(fmt, packed, count, out));
+    REQUIRE(count == 3);
+    REQUIRE(out == std::array< int8_t, 5 >{1, -2, 3, 0, 0});
+}
+
+TEST_CASE("concatenated formats keep their count field", "[bitpacker::counted]")
+{
+    constexpr auto message = bitpacker::concat(BP_STRING("u8"), BP_STRING("u4s8[#0]"));
+    REQUIRE_STATIC(bitpacker::impl::get_type_array(message)[2].count_field == 1);
+
+    const std::array< int8_t, 3 > values{-1, 2, -3};
+    std::array< uint8_t, 5 > packed{};
+    REQUIRE(bitpacker::pack_counted_into(message, packed, 0, 0xAB, 3, values));
+
+    uint8_t header = 0;
+    uint8_t count = 0;
+    std::array< int8_t, 3 > out{};
+    REQUIRE(bitpacker::unpack_counted(message, packed, header, count, out));
+    REQUIRE(header == 0xAB);
+    REQUIRE(count == 3);
+    REQUIRE(out == values);
+}
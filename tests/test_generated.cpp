@@ -0,0 +1,79 @@
+#include "span.hpp"
+
+namespace bitpacker {
+    using nonstd::span;
+}
+
+// generated headers only need core.hpp: included before bitpacker.hpp, this would not compile otherwise
+#include "test_messages.hpp"
+#include "test_common.hpp"
+#include <array>
+
+namespace {
+    template < std::size_t N >
+    constexpr bool same_bytes(const std::array< bitpacker::byte_type, N > &lhs, const std::array< bitpacker::byte_type, N > &rhs)
+    {
+        for (std::size_t i = 0; i < N; ++i) {
+            if (lhs[i] != rhs[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+}  // namespace
+
+TEST_CASE("generated code matches BP_STRING formats", "[bitpacker_gen]")
+{
+    constexpr auto message_fmt = BP_STRING("u12b1b1u14s24");
+    constexpr auto mixed_fmt = BP_STRING("u3p2b1[3]<u4[3]>P3<s13>s33u64s7");
+    static_assert(test_messages::MessageData::packed_bits == bitpacker::calcsize(message_fmt), "wrong size");
+    static_assert(test_messages::Mixed::packed_bits == bitpacker::calcsize(mixed_fmt), "wrong size");
+
+    const test_messages::MessageData data{3300, true, false, 4500, -1676479};
+    const test_messages::Mixed mixed{5, {true, false, true}, {0x1, 0xC, 0x7}, -3001, -4294967295LL, 0xFEDCBA9876543210ULL, -42};
+
+    for (bitpacker::size_type offset = 0; offset < 12; ++offset) {
+        std::array< bitpacker::byte_type, 32 > expected{};
+        std::array< bitpacker::byte_type, 32 > actual{};
+        expected.fill(0xA5);
+        actual.fill(0xA5);
+
+        bitpacker::pack_into(message_fmt, expected, offset, data.voltage, data.error, data.other, data.pressure, data.time);
+        bitpacker::store(actual, offset, data);
+        REQUIRE(actual == expected);
+
+        const auto message = bitpacker::get< test_messages::MessageData >(actual, offset);
+        REQUIRE(message.voltage == data.voltage);
+        REQUIRE(message.error == data.error);
+        REQUIRE(message.other == data.other);
+        REQUIRE(message.pressure == data.pressure);
+        REQUIRE(message.time == data.time);
+
+        bitpacker::pack_into(mixed_fmt, expected, offset, mixed.kind, mixed.flags, mixed.samples, mixed.offset, mixed.position, mixed.id, mixed.last);
+        test_messages::pack_into(actual, offset, mixed);
+        REQUIRE(actual == expected);
+
+        test_messages::Mixed unpacked{};
+        test_messages::unpack_from(actual, offset, unpacked);
+        const auto reference = bitpacker::unpack_from(mixed_fmt, actual, offset);
+        REQUIRE(unpacked.kind == std::get< 0 >(reference));
+        REQUIRE(unpacked.flags == std::get< 1 >(reference));
+        REQUIRE(unpacked.samples == std::get< 2 >(reference));
+        REQUIRE(unpacked.offset == std::get< 3 >(reference));
+        REQUIRE(unpacked.position == std::get< 4 >(reference));
+        REQUIRE(unpacked.id == std::get< 5 >(reference));
+        REQUIRE(unpacked.last == std::get< 6 >(reference));
+        REQUIRE(unpacked.offset == mixed.offset);
+        REQUIRE(unpacked.position == mixed.position);
+    }
+}
+
+TEST_CASE("generated code is constexpr", "[bitpacker_gen]")
+{
+    constexpr auto packed = [] {
+        std::array< bitpacker::byte_type, 7 > buffer{};
+        test_messages::pack_into(buffer, 0, test_messages::MessageData{3300, true, false, 4500, 16764793});
+        return buffer;
+    }();
+    STATIC_REQUIRE(same_bytes(packed, bitpacker::pack(BP_STRING("u12b1b1u14s24"), 3300, true, false, 4500, 16764793)));
+}
@@ -0,0 +1,35 @@
+// C++20 only: bitpacker uses std::span here, so the span-lite setup in test_common.hpp isn't needed
+#include "bitpacker/bitpacker.hpp"
+#include "constexpr_helpers.h"
+#include <catch2/catch.hpp>
+#include <array>
+
+using namespace bitpacker::literals;
+
+namespace {
+    auto format_in_other_function()
+    {
+        return bitpacker::fmt< "u4s12b1" >;
+    }
+}  // namespace
+
+TEST_CASE("string literal formats", "[format]")
+{
+    constexpr auto fmt = bitpacker::fmt< "u4s12b1" >;
+    REQUIRE_STATIC(bitpacker::calcsize(fmt) == 17);
+    REQUIRE_STATIC(bitpacker::calcbytes("u4s12b1"_bpf) == 3);
+
+    // the same string is always the same type, unlike BP_STRING()
+    REQUIRE_STATIC((std::is_same< std::remove_const_t< decltype(bitpacker::fmt< "u4s12b1" >) >, decltype("u4s12b1"_bpf) >::value));
+    REQUIRE((std::is_same< std::remove_const_t< decltype(fmt) >, decltype(format_in_other_function()) >::value));
+    REQUIRE_STATIC((!std::is_same< decltype(bitpacker::fmt< "u4s12b1" >), decltype(bitpacker::fmt< "u4s12b1p1" >) >::value));
+
+    constexpr auto packed = bitpacker::pack(fmt, 9U, -2, true);
+    REQUIRE(packed == bitpacker::pack(BP_STRING("u4s12b1"), 9U, -2, true));
+    REQUIRE(bitpacker::unpack("u4s12b1"_bpf, packed) == std::make_tuple(uint8_t{9}, int16_t{-2}, true));
+
+    // literal formats work everywhere a BP_STRING() format does
+    constexpr auto both = bitpacker::concat(bitpacker::fmt< "u4" >, BP_STRING("s12b1"));
+    REQUIRE_STATIC(bitpacker::calcsize(both) == 17);
+    REQUIRE(bitpacker::unpack(both, packed) == bitpacker::unpack(fmt, packed));
+}
@@ -0,0 +1,41 @@
+#include "test_common.hpp"
+#include "constexpr_helpers.h"
+#include <array>
+
+TEST_CASE("message template matches pack", "[bitpacker::prebake]")
+{
+    constexpr auto fmt = BP_STRING("u4u12p4u32u16b1");
+    constexpr auto heartbeat = bitpacker::prebake(fmt, 2, 0x123, bitpacker::hole, bitpacker::hole, true);
+    REQUIRE_STATIC(heartbeat.hole_count == 2);
+    REQUIRE_STATIC(heartbeat.holes[0] == 2);
+    REQUIRE_STATIC(heartbeat.holes[1] == 3);
+    REQUIRE_STATIC(heartbeat.image() == bitpacker::pack(fmt, 2, 0x123, 0, 0, true));
+
+    REQUIRE(heartbeat.pack(0xDEADBEEFU, 0x1234) == bitpacker::pack(fmt, 2, 0x123, 0xDEADBEEFU, 0x1234, true));
+    REQUIRE(heartbeat.pack(1U, 0xFFFF) == bitpacker::pack(fmt, 2, 0x123, 1U, 0xFFFF, true));
+}
+
+TEST_CASE("message template fills holes in place", "[bitpacker::prebake]")
+{
+    constexpr auto fmt = BP_STRING("s5P3u12[2]b1u7");
+    constexpr auto msg = bitpacker::prebake(fmt, bitpacker::hole, std::array< uint16_t, 2 >{0xABC, 0x123}, bitpacker::hole, 0x55);
+
+    auto buffer = msg.image();
+    msg.fill(buffer, -3, true);
+    REQUIRE(buffer == bitpacker::pack(fmt, -3, std::array< uint16_t, 2 >{0xABC, 0x123}, true, 0x55));
+
+    // only the holes are written, so the buffer can be reused for the next message
+    msg.fill(buffer, 15, false);
+    REQUIRE(buffer == bitpacker::pack(fmt, 15, std::array< uint16_t, 2 >{0xABC, 0x123}, false, 0x55));
+}
+
+TEST_CASE("message template without holes or bound fields", "[bitpacker::prebake]")
+{
+    constexpr auto fmt = BP_STRING("u3p2s11");
+    constexpr auto fixed = bitpacker::prebake(fmt, 5, -100);
+    REQUIRE_STATIC(fixed.hole_count == 0);
+    REQUIRE_STATIC(fixed.pack() == bitpacker::pack(fmt, 5, -100));
+
+    constexpr auto open = bitpacker::prebake(fmt, bitpacker::hole, bitpacker::hole);
+    REQUIRE_STATIC(open.pack(5, -100) == bitpacker::pack(fmt, 5, -100));
+}
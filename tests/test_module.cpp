@@ -0,0 +1,25 @@
+// built with -DBITPACKER_BUILD_MODULE=ON: the public interface through `import bitpacker;` instead of the headers
+#include <catch2/catch.hpp>
+#include <array>
+#include <cstdint>
+#include <tuple>
+
+import bitpacker;
+
+using namespace bitpacker::literals;
+
+TEST_CASE("pack and unpack through the module", "[bitpacker::module]")
+{
+    constexpr auto fmt = bitpacker::fmt< "u12b1s7" >;
+    const auto packed = bitpacker::pack(fmt, 0x123, true, -4);
+    REQUIRE(packed == std::array< bitpacker::byte_type, 3 >{0x12, 0x3F, 0xC0});
+    REQUIRE(bitpacker::calcsize(fmt) == 20);
+
+    const auto [value, flag, small] = bitpacker::unpack(fmt, packed);
+    REQUIRE(value == 0x123);
+    REQUIRE(flag);
+    REQUIRE(small == -4);
+
+    REQUIRE(bitpacker::unpack("u12b1s7"_bpf, packed) == std::make_tuple(uint16_t{0x123}, true, int8_t{-4}));
+    REQUIRE(bitpacker::view(fmt, packed).get< 2 >() == -4);
+}
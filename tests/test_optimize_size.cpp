@@ -0,0 +1,57 @@
+// built with BITPACKER_OPTIMIZE_SIZE, together with some of the format tests, so they all run through the shared kernels
+#include "test_common.hpp"
+#include "constexpr_helpers.h"
+#include "bitpacker/runtime.hpp"
+#include <array>
+
+TEST_CASE("size optimized kernels are used", "[bitpacker::optimize_size]")
+{
+    REQUIRE_STATIC(bitpacker::impl::optimize_size);
+    constexpr auto fmt = BP_STRING("u4<s12[3]p2b1");
+    constexpr auto raw_fmt = BP_STRING("u4r16");
+    using table = bitpacker::impl::item_table< std::remove_const_t< decltype(fmt) > >;
+    REQUIRE_STATIC(table::enabled);
+    REQUIRE_STATIC(table::value_count == 5);
+    REQUIRE_STATIC(table::op_count == 6);
+    REQUIRE_STATIC(table::first_value[2] == 4);
+    REQUIRE_STATIC(table::ops[2].offset == 16);
+    REQUIRE_STATIC(table::ops[2].lsb_first);
+    REQUIRE_STATIC(table::ops[5].format == 'p');
+
+    // raw and text fields keep the per field code
+    REQUIRE_STATIC(!bitpacker::impl::item_table< std::remove_const_t< decltype(raw_fmt) > >::enabled);
+}
+
+TEST_CASE("size optimized kernels match the runtime engine", "[bitpacker::optimize_size]")
+{
+    constexpr auto fmt = BP_STRING("u4b1<s12p3P2>u64s7[3]<u9[2]P5b3s64");
+    const auto compiled = bitpacker::compile("u4b1<s12p3P2>u64s7[3]<u9[2]P5b3s64");
+    REQUIRE(compiled.valid());
+
+    const std::array< int8_t, 3 > s7{-64, 63, -1};
+    const std::array< uint16_t, 2 > u9{0x1A5, 0x003};
+    const auto packed = bitpacker::pack(fmt, 0xA, true, -1000, 0xFEDCBA9876543210ULL, s7, u9, true, -5);
+
+    const std::array< uint64_t, 10 > values{0xA, 1, static_cast< uint64_t >(-1000), 0xFEDCBA9876543210ULL,
+                                            static_cast< uint64_t >(-64), 63, static_cast< uint64_t >(-1), 0x1A5, 0x003, 1};
+    std::array< uint8_t, bitpacker::calcbytes(fmt) > expected{};
+    std::array< uint64_t, 11 > runtime_values{};
+    std::copy(values.begin(), values.end(), runtime_values.begin());
+    runtime_values[10] = static_cast< uint64_t >(-5);
+    REQUIRE(compiled.pack(expected, runtime_values));
+    REQUIRE(packed == expected);
+
+    const auto unpacked = bitpacker::unpack(fmt, packed);
+    REQUIRE(std::get< 0 >(unpacked) == 0xA);
+    REQUIRE(std::get< 1 >(unpacked) == true);
+    REQUIRE(std::get< 2 >(unpacked) == -1000);
+    REQUIRE(std::get< 3 >(unpacked) == 0xFEDCBA9876543210ULL);
+    REQUIRE(std::get< 4 >(unpacked) == s7);
+    REQUIRE(std::get< 5 >(unpacked) == u9);
+    REQUIRE(std::get< 6 >(unpacked) == true);
+    REQUIRE(std::get< 7 >(unpacked) == -5);
+
+    // the kernels are constexpr too
+    constexpr auto static_packed = bitpacker::pack(BP_STRING("<u5s11"), 3U, -2);
+    REQUIRE_STATIC(std::get< 1 >(bitpacker::unpack(BP_STRING("<u5s11"), static_packed)) == -2);
+}
@@ -0,0 +1,123 @@
+#include "test_common.hpp"
+#include "constexpr_helpers.h"
+#include <array>
+#include <optional>
+
+namespace {
+    // version, has_position flag, optional position group, has_name flag, optional name group, checksum
+    constexpr auto fmt = BP_STRING("u4b1b1{#1:s12s12p2}{#2:t16}u8");
+}
+
+TEST_CASE("parse optional groups", "[bitpacker::optional]")
+{
+    namespace bpimpl = bitpacker::impl;
+    REQUIRE_STATIC(bpimpl::validate_format(fmt));
+    REQUIRE_STATIC(!bpimpl::validate_format(BP_STRING("b1{#0:u4")));
+    REQUIRE_STATIC(!bpimpl::validate_format(BP_STRING("b1u4}")));
+    REQUIRE_STATIC(!bpimpl::validate_format(BP_STRING("b1{#0:{#0:u4}}")));
+    REQUIRE_STATIC(!bpimpl::validate_format(BP_STRING("b1{0:u4}")));
+    REQUIRE_STATIC(bpimpl::count_non_padding(fmt) == 7);
+    REQUIRE_STATIC(bpimpl::count_groups(fmt) == 2);
+    REQUIRE_STATIC(bpimpl::get_group_array(fmt)[0].begin == 6);
+    REQUIRE_STATIC(bpimpl::get_group_array(fmt)[0].bits == 26);
+    REQUIRE_STATIC(bpimpl::get_group_array(fmt)[1].gate == 2);
+    REQUIRE_STATIC(bpimpl::valid_optional_format(fmt));
+    REQUIRE_STATIC(!bpimpl::valid_optional_format(BP_STRING("u1{#0:u4}")));   // gate is not a 'b' field
+    REQUIRE_STATIC(!bpimpl::valid_optional_format(BP_STRING("{#0:b1u4}")));   // gate is inside the group
+    REQUIRE_STATIC(bitpacker::calcsize(fmt) == 4 + 1 + 1 + 26 + 16 + 8);
+}
+
+TEST_CASE("optional groups that are all present", "[bitpacker::optional]")
+{
+    std::array< uint8_t, bitpacker::calcbytes(fmt) > packed{};
+    const std::array< char, 2 > name{'o', 'k'};
+    REQUIRE(bitpacker::pack_optional_into(fmt, packed, 0, 3, true, true, -5, 100, name, 0xA5) == bitpacker::calcsize(fmt));
+    REQUIRE(packed == bitpacker::pack(BP_STRING("u4b1b1s12s12p2t16u8"), 3, true, true, -5, 100, name, 0xA5));
+
+    const auto [version, has_pos, has_name, x, y, n, check] = *bitpacker::unpack_optional(fmt, packed);
+    REQUIRE(version == 3);
+    REQUIRE(has_pos);
+    REQUIRE(has_name);
+    REQUIRE(x == std::optional< int16_t >(-5));
+    REQUIRE(y == std::optional< int16_t >(100));
+    REQUIRE(n == name);
+    REQUIRE(check == 0xA5);
+}
+
+TEST_CASE("missing optional groups take no space", "[bitpacker::optional]")
+{
+    std::array< uint8_t, bitpacker::calcbytes(fmt) > packed{};
+    const std::array< char, 2 > name{'h', 'i'};
+    const std::optional< int16_t > none{};
+    REQUIRE(bitpacker::pack_optional_into(fmt, packed, 0, 3, false, true, none, none, name, 0xA5) == 4 + 1 + 1 + 16 + 8);
+    REQUIRE(std::equal(packed.begin(), packed.begin() + 4, bitpacker::pack(BP_STRING("u4b1b1t16u8"), 3, false, true, name, 0xA5).begin()));
+
+    const auto unpacked = *bitpacker::unpack_optional(fmt, packed);
+    REQUIRE_FALSE(std::get< 3 >(unpacked).has_value());
+    REQUIRE_FALSE(std::get< 4 >(unpacked).has_value());
+    REQUIRE(std::get< 5 >(unpacked) == name);
+    REQUIRE(std::get< 6 >(unpacked) == 0xA5);
+
+    std::array< uint8_t, bitpacker::calcbytes(fmt) > shifted{};
+    REQUIRE(bitpacker::pack_optional_into(fmt, shifted, 3, 9, true, false, -1, 1, name, 0x11) == 4 + 1 + 1 + 26 + 8);
+    const auto from_offset = *bitpacker::unpack_optional_from(fmt, shifted, 3);
+    REQUIRE(std::get< 3 >(from_offset) == std::optional< int16_t >(-1));
+    REQUIRE(std::get< 4 >(from_offset) == std::optional< int16_t >(1));
+    REQUIRE_FALSE(std::get< 5 >(from_offset).has_value());
+    REQUIRE(std::get< 6 >(from_offset) == 0x11);
+}
+
+TEST_CASE("optional groups check the output size", "[bitpacker::optional]")
+{
+    const std::array< char, 2 > name{'n', 'o'};
+    const std::optional< int16_t > none{};
+    std::array< uint8_t, 4 > small{};
+    small.fill(0xEE);
+    // 56 bits with every group present, only 30 without the position group
+    REQUIRE(bitpacker::pack_optional_into(fmt, small, 0, 3, true, true, -5, 100, name, 0xA5) == 0);
+    REQUIRE(small == std::array< uint8_t, 4 >{0xEE, 0xEE, 0xEE, 0xEE});
+    REQUIRE(bitpacker::pack_optional_into(fmt, small, 2, 3, false, true, none, none, name, 0xA5) == 30);
+    REQUIRE(bitpacker::pack_optional_into(fmt, small, 3, 3, false, true, none, none, name, 0xA5) == 0);
+}
+
+TEST_CASE("truncated optional frames are rejected", "[bitpacker::optional]")
+{
+    std::array< uint8_t, bitpacker::calcbytes(fmt) > packed{};
+    const std::array< char, 2 > name{'o', 'k'};
+    REQUIRE(bitpacker::pack_optional_into(fmt, packed, 0, 3, true, true, -5, 100, name, 0xA5) == 56);
+
+    // 56 bits with both groups present: 6 bytes hold the gates but not the whole frame
+    REQUIRE_FALSE(bitpacker::unpack_optional(fmt, bitpacker::span< const uint8_t >(packed.data(), 6)).has_value());
+    REQUIRE(bitpacker::unpack_optional(fmt, packed).has_value());
+    REQUIRE_FALSE(bitpacker::unpack_optional_from(fmt, packed, 5).has_value());
+
+    // the same bytes with the position gate cleared are a 30 bit frame
+    packed[0] &= 0xF7;
+    REQUIRE_FALSE(bitpacker::unpack_optional(fmt, bitpacker::span< const uint8_t >(packed.data(), 3)).has_value());
+    const auto short_frame = bitpacker::unpack_optional(fmt, bitpacker::span< const uint8_t >(packed.data(), 4));
+    REQUIRE(short_frame.has_value());
+    REQUIRE_FALSE(std::get< 3 >(*short_frame).has_value());
+
+    // gates past the end of the input are never read
+    REQUIRE_FALSE(bitpacker::unpack_optional(fmt, bitpacker::span< const uint8_t >()).has_value());
+}
+
+TEST_CASE("concatenated formats keep their optional group gates", "[bitpacker::optional]")
+{
+    constexpr auto message = bitpacker::concat(BP_STRING("b1u3"), BP_STRING("b1{#0:u4}u4"));
+    REQUIRE_STATIC(bitpacker::impl::get_group_array(message)[0].gate == 2);
+
+    std::array< uint8_t, 2 > packed{};
+    REQUIRE(bitpacker::pack_optional_into(message, packed, 0, true, 5, false, 7, 9) == 9);
+    const auto [flag, version, present, value, trailer] = *bitpacker::unpack_optional(message, packed);
+    REQUIRE(flag);
+    REQUIRE(version == 5);
+    REQUIRE_FALSE(present);
+    REQUIRE_FALSE(value.has_value());
+    REQUIRE(trailer == 9);
+
+    // renumbered references can need more digits than the original
+    constexpr auto wide = bitpacker::concat(BP_STRING("u1u1u1u1u1u1u1u1u1u1"), BP_STRING("b1{#0:u4}"));
+    REQUIRE_STATIC(bitpacker::impl::get_group_array(wide)[0].gate == 10);
+    REQUIRE_STATIC(bitpacker::calcsize(wide) == 15);
+}
@@ -464,3 +464,24 @@ TEST_CASE("Can insert non-aligned 64-bit values", "[pack]") {
     REQUIRE(input1 == output1);
     REQUIRE(input2 == output2);
 }
+
+TEST_CASE("Bulk insert of bytes matches per-byte insert", "[pack]") {
+    std::array<uint8_t, 24> src{};
+    for (size_t i = 0; i < src.size(); ++i) {
+        src[i] = static_cast<uint8_t>(0x3B * (i + 1));
+    }
+
+    for (size_t offset = 0; offset < 12; ++offset) {
+        for (size_t count = 0; count <= 20; ++count) {
+            std::array<uint8_t, 24> bulk{};
+            bulk.fill(0xA5);
+            std::array<uint8_t, 24> bytewise = bulk;
+
+            bitpacker::impl::insert_bytes(bulk, offset, src.data(), count);
+            for (size_t i = 0; i < count; ++i) {
+                bitpacker::insert<uint8_t>(bytewise, offset + (i * 8), 8, src[i]);
+            }
+            REQUIRE(bulk == bytewise);
+        }
+    }
+}
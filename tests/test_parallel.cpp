@@ -0,0 +1,150 @@
+#include "test_common.hpp"
+#include "bitpacker/parallel.hpp"
+#include <array>
+#include <stdexcept>
+#include <vector>
+
+TEST_CASE("aligned record step", "[bitpacker::batch]")
+{
+    REQUIRE(bitpacker::impl::aligned_record_step(8, 8) == 1);
+    REQUIRE(bitpacker::impl::aligned_record_step(16, 8) == 1);
+    REQUIRE(bitpacker::impl::aligned_record_step(12, 8) == 2);
+    REQUIRE(bitpacker::impl::aligned_record_step(13, 8) == 8);
+    REQUIRE(bitpacker::impl::aligned_record_step(20, 512) == 128);
+}
+
+TEST_CASE("pack chunks start on cache lines in memory", "[bitpacker::batch]")
+{
+    alignas(64) std::array< uint8_t, 256 > buffer{};
+    const uint8_t *aligned = buffer.data();
+    REQUIRE(bitpacker::impl::cache_line_record(aligned, 8, 1, 0) == 0);
+    REQUIRE(bitpacker::impl::cache_line_record(aligned, 8, 1, 10) == 64);
+    // 3 bytes past a cache line: records of 8, 12 and 13 bits start the next line at records 61, 126 and 392
+    REQUIRE(bitpacker::impl::cache_line_record(aligned + 3, 8, 1, 0) == 61);
+    REQUIRE(bitpacker::impl::cache_line_record(aligned + 3, 12, 2, 0) == 126);
+    REQUIRE(bitpacker::impl::cache_line_record(aligned + 3, 13, 8, 0) == 392);
+    // records of 16 bits never start on an odd byte, the cut is kept
+    REQUIRE(bitpacker::impl::cache_line_record(aligned + 1, 16, 1, 8) == 8);
+}
+
+TEST_CASE("unpack batch of records", "[bitpacker::batch]")
+{
+    constexpr auto fmt = BP_STRING("u5P3<s5");
+    const std::array< uint8_t, 3 > a{31, 0, 7};
+    const std::array< int8_t, 3 > b{-16, 15, -1};
+    std::array< uint8_t, 5 > packed{};
+    bitpacker::pack_columns(fmt, packed, 3, a, b);
+
+    std::array< bitpacker::unpack_result_t< decltype(fmt) >, 3 > records{};
+    bitpacker::unpack_batch(fmt, packed, 3, records);
+    for (size_t i = 0; i < 3; ++i) {
+        REQUIRE(std::get< 0 >(records[i]) == a[i]);
+        REQUIRE(std::get< 1 >(records[i]) == b[i]);
+    }
+
+    std::array< uint8_t, 3 > a_out{};
+    std::array< int8_t, 3 > b_out{};
+    bitpacker::unpack_columns(fmt, packed, 3, a_out, b_out);
+    REQUIRE(a_out == a);
+    REQUIRE(b_out == b);
+}
+
+TEST_CASE("parallel unpack matches serial unpack", "[bitpacker::batch]")
+{
+    constexpr auto fmt = BP_STRING("u7b1s5");
+    constexpr size_t count = 1001;
+    std::vector< uint8_t > a(count);
+    std::vector< bool > flags(count);
+    std::vector< int8_t > b(count);
+    for (size_t i = 0; i < count; ++i) {
+        a[i] = static_cast< uint8_t >(i % 128);
+        flags[i] = (i % 3) == 0;
+        b[i] = static_cast< int8_t >(static_cast< int >(i % 32) - 16);
+    }
+    std::vector< uint8_t > packed((count * bitpacker::calcsize(fmt) + 7) / 8);
+    bitpacker::pack_columns(fmt, packed, count, a, flags, b);
+
+    std::vector< bitpacker::unpack_result_t< decltype(fmt) > > serial(count);
+    std::vector< bitpacker::unpack_result_t< decltype(fmt) > > parallel(count);
+    bitpacker::unpack_batch(fmt, packed, count, serial);
+    REQUIRE_FALSE(bitpacker::parallel_unpack_batch(fmt, packed, count + 1, 4, parallel));
+    REQUIRE(bitpacker::parallel_unpack_batch(fmt, packed, count, 4, parallel));
+    REQUIRE(serial == parallel);
+
+    std::vector< uint8_t > a_out(count);
+    std::vector< uint8_t > flags_out(count); // not vector<bool>, threads write neighboring elements
+    std::vector< int8_t > b_out(count);
+    bitpacker::parallel_unpack_columns(fmt, packed, count, 3, a_out, flags_out, b_out);
+    REQUIRE(a_out == a);
+    REQUIRE(b_out == b);
+    for (size_t i = 0; i < count; ++i) {
+        REQUIRE(static_cast< bool >(flags_out[i]) == flags[i]);
+    }
+}
+
+TEST_CASE("parallel pack of bit-dense records matches serial pack", "[bitpacker::batch]")
+{
+    // 13 bit records, chunks must start on a cache line to not share bytes
+    constexpr auto fmt = BP_STRING("u7P1s5");
+    constexpr size_t count = 5000;
+    std::vector< uint8_t > a(count);
+    std::vector< int8_t > b(count);
+    std::vector< bitpacker::unpack_result_t< decltype(fmt) > > records(count);
+    for (size_t i = 0; i < count; ++i) {
+        a[i] = static_cast< uint8_t >((i * 7) % 128);
+        b[i] = static_cast< int8_t >(static_cast< int >(i % 32) - 16);
+        records[i] = std::make_tuple(a[i], b[i]);
+    }
+
+    const size_t bytes = (count * bitpacker::calcsize(fmt) + 7) / 8;
+    std::vector< uint8_t > serial(bytes, 0x5A);
+    std::vector< uint8_t > batch(bytes, 0x5A);
+    std::vector< uint8_t > parallel(bytes, 0x5A);
+    std::vector< uint8_t > parallel_columns(bytes, 0x5A);
+    bitpacker::pack_columns(fmt, serial, count, a, b);
+    bitpacker::pack_batch(fmt, batch, count, records);
+    bitpacker::parallel_pack_batch(fmt, parallel, count, 8, records);
+    bitpacker::parallel_pack_columns(fmt, parallel_columns, count, 5, a, b);
+
+    REQUIRE(batch == serial);
+    REQUIRE(parallel == serial);
+    REQUIRE(parallel_columns == serial);
+
+    // output that doesn't start on a cache line
+    for (size_t shift = 1; shift < 4; ++shift) {
+        std::vector< uint8_t > shifted(bytes + shift, 0x5A);
+        bitpacker::parallel_pack_batch(fmt, bitpacker::span< uint8_t >(shifted.data() + shift, bytes), count, 6, records);
+        REQUIRE(std::equal(serial.begin(), serial.end(), shifted.begin() + static_cast< std::ptrdiff_t >(shift)));
+    }
+}
+
+namespace {
+    // output container that throws for one record, like a checked container would
+    struct throwing_output {
+        std::vector< std::tuple< uint8_t > > records;
+        size_t bad;
+        auto &operator[](size_t i)
+        {
+            if (i == bad) {
+                throw std::out_of_range("bad record");
+            }
+            return records[i];
+        }
+    };
+}
+
+TEST_CASE("parallel functions rethrow exceptions from the threads", "[bitpacker::batch]")
+{
+    constexpr auto fmt = BP_STRING("u8");
+    const std::vector< uint8_t > packed(100, 7);
+    for (const size_t bad : {size_t{0}, size_t{99}}) {
+        throwing_output out{std::vector< std::tuple< uint8_t > >(100), bad};
+        REQUIRE_THROWS_AS(bitpacker::parallel_unpack_batch(fmt, packed, 100, 4, out), std::out_of_range);
+        REQUIRE(std::get< 0 >(out.records[50]) == 7);
+    }
+
+    // 0 threads uses the hardware concurrency
+    std::vector< bitpacker::unpack_result_t< decltype(fmt) > > all(100);
+    bitpacker::parallel_unpack_batch(fmt, packed, 100, 0, all);
+    REQUIRE(std::get< 0 >(all[99]) == 7);
+}
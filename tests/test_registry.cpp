@@ -0,0 +1,72 @@
+#include "test_common.hpp"
+#include "constexpr_helpers.h"
+#include <array>
+#include <utility>
+
+TEST_CASE("registry with small ids uses a dense table", "[bitpacker::registry]")
+{
+    int status_voltage = 0;
+    bool status_error = false;
+    int16_t pos_x = 0;
+    int16_t pos_y = 0;
+    auto reg = bitpacker::registry(BP_STRING("u8"),
+                                   bitpacker::message< 1 >(BP_STRING("u12b1p3"), [&](uint16_t voltage, bool error) {
+                                       status_voltage = voltage;
+                                       status_error = error;
+                                   }),
+                                   bitpacker::message< 7 >(BP_STRING("s16s16"), [&](int16_t x, int16_t y) {
+                                       pos_x = x;
+                                       pos_y = y;
+                                   }));
+    REQUIRE_STATIC(decltype(reg)::dense);
+
+    REQUIRE(reg.dispatch(bitpacker::pack(BP_STRING("u8u12b1p3"), 1, 3300, true)));
+    REQUIRE(status_voltage == 3300);
+    REQUIRE(status_error);
+
+    std::array< uint8_t, 6 > shifted{};
+    bitpacker::pack_into(BP_STRING("u8s16s16"), shifted, 4, 7, -20, 30);
+    REQUIRE(reg.dispatch(shifted, 4));
+    REQUIRE(pos_x == -20);
+    REQUIRE(pos_y == 30);
+
+    REQUIRE_FALSE(reg.dispatch(bitpacker::pack(BP_STRING("u8u32"), 2, 0)));
+    REQUIRE_FALSE(reg.dispatch(bitpacker::pack(BP_STRING("u8u32"), 200, 0)));
+}
+
+namespace {
+    template < std::size_t... Idx >
+    auto make_sparse_registry(std::array< uint64_t, sizeof...(Idx) > &seen, std::index_sequence< Idx... > /*unused*/)
+    {
+        return bitpacker::registry(BP_STRING("u32"),
+                                   bitpacker::message< (Idx + 1) * 2654435761U % 4000000000U >(BP_STRING("u16"), [&seen](uint16_t v) {
+                                       seen[Idx] = v;
+                                   })...);
+    }
+}
+
+TEST_CASE("registry with sparse ids uses a perfect hash", "[bitpacker::registry]")
+{
+    constexpr std::size_t count = 64;
+    std::array< uint64_t, count > seen{};
+    auto reg = make_sparse_registry(seen, std::make_index_sequence< count >());
+    REQUIRE_STATIC(!decltype(reg)::dense);
+
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto id = static_cast< uint32_t >((i + 1) * 2654435761U % 4000000000U);
+        REQUIRE(reg.dispatch(bitpacker::pack(BP_STRING("u32u16"), id, static_cast< uint16_t >(i + 100))));
+        REQUIRE(seen[i] == i + 100);
+    }
+    REQUIRE_FALSE(reg.dispatch(bitpacker::pack(BP_STRING("u32u16"), 12345, 1)));
+    REQUIRE_FALSE(reg.dispatch(bitpacker::pack(BP_STRING("u32u16"), 0, 1)));
+}
+
+TEST_CASE("message ids must fit in the id field", "[bitpacker::registry]")
+{
+    namespace bpimpl = bitpacker::impl;
+    constexpr auto message = bitpacker::message< 16 >(BP_STRING("u8"), [](uint8_t /*unused*/) {});
+    using entry = std::remove_const_t< decltype(message) >;
+    // registry(BP_STRING("u4"), message< 16 >(...)) does not compile: id 16 can never be read from a 4 bit field
+    REQUIRE_STATIC(!bpimpl::fit_in_bits(bpimpl::registry_dispatch< entry >::ids, 4));
+    REQUIRE_STATIC(bpimpl::fit_in_bits(bpimpl::registry_dispatch< entry >::ids, 5));
+}
@@ -0,0 +1,292 @@
+#include "test_common.hpp"
+#include "bitpacker/runtime.hpp"
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("parse format strings at runtime", "[bitpacker::compile]")
+{
+    REQUIRE(bitpacker::compile("u4b1<s12p3P2u64").valid());
+    REQUIRE(bitpacker::compile("u4b1<s12p3P2u64").size() == 4 + 1 + 12 + 3 + 2 + 64);
+    REQUIRE(bitpacker::compile("u4b1<s12p3P2u64").bytes() == 11);
+    REQUIRE(bitpacker::compile("u4b1<s12p3P2u64").field_count() == 4);
+    REQUIRE(bitpacker::compile("u4u12[3]").field_count() == 4);
+    REQUIRE(bitpacker::compile("u4u12[3]").size() == 40);
+
+    REQUIRE_FALSE(bitpacker::compile("u4x3").valid());
+    REQUIRE_FALSE(bitpacker::compile("u0").valid());
+    REQUIRE_FALSE(bitpacker::compile("u").valid());
+    REQUIRE_FALSE(bitpacker::compile("u65").valid());
+    REQUIRE_FALSE(bitpacker::compile("u4[0]").valid());
+    REQUIRE_FALSE(bitpacker::compile("u4[2").valid());
+    REQUIRE_FALSE(bitpacker::compile("u4f24").valid());
+    REQUIRE_FALSE(bitpacker::compile("u4u12<").valid());
+    REQUIRE_FALSE(bitpacker::compile("u4t8<").valid());
+    REQUIRE(bitpacker::compile("u4t8").valid());
+    REQUIRE(bitpacker::compile("u4f32").valid());
+    REQUIRE(bitpacker::compile("u4u4<").valid());
+    REQUIRE(bitpacker::compile("u4u16>").valid());
+    REQUIRE_FALSE(bitpacker::compiled_format().valid());
+}
+
+TEST_CASE("compiled format matches the compile time engine", "[bitpacker::compile]")
+{
+    const auto fmt = bitpacker::compile("u4b1<s12p3P2>u64<u7s33");
+    REQUIRE(fmt.valid());
+
+    const auto expected = bitpacker::pack(BP_STRING("u4b1<s12p3P2>u64<u7s33"), 0xB, true, -1234, 0xFEDCBA9876543210ULL, 0x55, -4000000000LL);
+    const std::array< uint64_t, 6 > values{0xB, 1, static_cast< uint64_t >(-1234), 0xFEDCBA9876543210ULL, 0x55, static_cast< uint64_t >(-4000000000LL)};
+    std::array< uint8_t, expected.size() > packed{};
+    REQUIRE(fmt.pack(packed, values));
+    REQUIRE(packed == expected);
+
+    std::array< uint64_t, 6 > unpacked{};
+    REQUIRE(fmt.unpack(packed, unpacked));
+    REQUIRE(unpacked == values);
+}
+
+TEST_CASE("compiled format at bit offsets", "[bitpacker::compile]")
+{
+    const auto fmt = bitpacker::compile("s5u30b1u20");
+    const std::array< uint64_t, 4 > values{static_cast< uint64_t >(-3), 0x2BCDEF01, 1, 0xABCDE};
+    for (bitpacker::size_type offset = 0; offset < 16; ++offset) {
+        std::array< uint8_t, 16 > expected{};
+        expected.fill(0xA5);
+        bitpacker::pack_into(BP_STRING("s5u30b1u20"), expected, offset, -3, 0x2BCDEF01, true, 0xABCDE);
+        std::array< uint8_t, 16 > packed{};
+        packed.fill(0xA5);
+        REQUIRE(fmt.pack_into(packed, offset, values));
+        REQUIRE(packed == expected);
+
+        std::array< uint64_t, 4 > unpacked{};
+        REQUIRE(fmt.unpack_from(packed, offset, unpacked));
+        REQUIRE(unpacked == values);
+    }
+}
+
+TEST_CASE("compiled format with raw and text fields", "[bitpacker::compile]")
+{
+    const auto fmt = bitpacker::compile("u4t24<r16>s5r12");
+    REQUIRE(fmt.valid());
+    REQUIRE(fmt.field_count() == 5);
+    REQUIRE(fmt.data_bytes() == 3 + 2 + 2);
+
+    const std::array< char, 3 > text{'a', 'b', 'c'};
+    const std::array< uint8_t, 2 > raw16{0xA5, 0xC3};
+    const std::array< uint8_t, 2 > raw12{0x12, 0x30};
+    const std::array< uint64_t, 5 > values{0x9, 0, 0, static_cast< uint64_t >(-7), 0};
+    const std::array< uint8_t, 7 > data{'a', 'b', 'c', 0xA5, 0xC3, 0x12, 0x30};
+    for (bitpacker::size_type offset = 0; offset < 16; ++offset) {
+        std::array< uint8_t, 10 > expected{};
+        expected.fill(0x5A);
+        bitpacker::pack_into(BP_STRING("u4t24<r16>s5r12"), expected, offset, 0x9, text, raw16, -7, raw12);
+        std::array< uint8_t, 10 > packed{};
+        packed.fill(0x5A);
+        REQUIRE(fmt.pack_into(packed, offset, values, data));
+        REQUIRE(packed == expected);
+
+        std::array< uint64_t, 5 > unpacked{};
+        std::array< uint8_t, 7 > unpacked_data{};
+        REQUIRE(fmt.unpack_from(packed, offset, unpacked, unpacked_data));
+        REQUIRE(unpacked == std::array< uint64_t, 5 >{0x9, 0, 3, static_cast< uint64_t >(-7), 5});
+        REQUIRE(unpacked_data == data);
+    }
+
+    std::array< uint8_t, 10 > buffer{};
+    std::array< uint8_t, 6 > short_data{};
+    REQUIRE_FALSE(fmt.pack(buffer, values));
+    REQUIRE_FALSE(fmt.pack(buffer, values, short_data));
+    std::array< uint64_t, 5 > unpacked{};
+    REQUIRE_FALSE(fmt.unpack(buffer, unpacked, short_data));
+}
+
+TEST_CASE("compiled format with long and partial raw fields", "[bitpacker::compile]")
+{
+    constexpr auto ct_fmt = BP_STRING("u3t72<r12>r80u5");
+    const auto fmt = bitpacker::compile("u3t72<r12>r80u5");
+    REQUIRE(fmt.data_bytes() == 9 + 2 + 10);
+
+    const std::array< char, 9 > text{'b', 'i', 't', 'p', 'a', 'c', 'k', 'e', 'r'};
+    const std::array< uint8_t, 2 > raw12{0x5A, 0x90};
+    const std::array< uint8_t, 10 > raw80{0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    const std::array< uint64_t, 5 > values{5, 0, 0, 0, 17};
+    std::array< uint8_t, 21 > data{};
+    bitpacker::impl::copy(text.begin(), text.end(), data.begin());
+    bitpacker::impl::copy(raw12.begin(), raw12.end(), data.begin() + 9);
+    bitpacker::impl::copy(raw80.begin(), raw80.end(), data.begin() + 11);
+    for (bitpacker::size_type offset = 0; offset < 16; ++offset) {
+        std::array< uint8_t, 24 > expected{};
+        expected.fill(0xC3);
+        bitpacker::pack_into(ct_fmt, expected, offset, 5, text, raw12, raw80, 17);
+        std::array< uint8_t, 24 > packed{};
+        packed.fill(0xC3);
+        REQUIRE(fmt.pack_into(packed, offset, values, data));
+        REQUIRE(packed == expected);
+
+        // unpacking a partial little endian raw field does not give back what was packed, same as the compile time engine
+        const auto ct_values = bitpacker::unpack_from(ct_fmt, packed, offset);
+        std::array< uint64_t, 5 > unpacked{};
+        std::array< uint8_t, 21 > unpacked_data{};
+        REQUIRE(fmt.unpack_from(packed, offset, unpacked, unpacked_data));
+        REQUIRE(unpacked == std::array< uint64_t, 5 >{5, 0, 9, 11, 17});
+        REQUIRE(std::equal(text.begin(), text.end(), unpacked_data.begin()));
+        REQUIRE(std::get< 2 >(ct_values)[0] == unpacked_data[9]);
+        REQUIRE(std::get< 2 >(ct_values)[1] == unpacked_data[10]);
+        REQUIRE(std::equal(raw80.begin(), raw80.end(), unpacked_data.begin() + 11));
+    }
+}
+
+TEST_CASE("compiled format with float fields", "[bitpacker::compile]")
+{
+    using bitpacker::compiled_format;
+    const auto fmt = bitpacker::compile("f16f32f64");
+    REQUIRE(fmt.valid());
+    const std::array< uint64_t, 3 > values{compiled_format::from_double(-2.5), compiled_format::from_double(3.5), compiled_format::from_double(0.1)};
+    std::array< uint8_t, 14 > packed{};
+    REQUIRE(fmt.pack(packed, values));
+    REQUIRE(packed == std::array< uint8_t, 14 >{0xC1, 0x00, 0x40, 0x60, 0x00, 0x00, 0x3F, 0xB9, 0x99, 0x99, 0x99, 0x99, 0x99, 0x9A});
+    std::array< uint64_t, 3 > unpacked{};
+    REQUIRE(fmt.unpack(packed, unpacked));
+    REQUIRE(unpacked == values);
+
+    // half precision rounds to nearest even, and covers subnormals and infinity
+    const auto half = bitpacker::compile("f16");
+    const auto to_half = [&half](double v) {
+        std::array< uint8_t, 2 > out{};
+        half.pack(out, std::array< uint64_t, 1 >{compiled_format::from_double(v)});
+        return static_cast< unsigned >((out[0] << 8U) | out[1]);
+    };
+    const auto from_half = [&half](uint8_t high, uint8_t low) {
+        std::array< uint64_t, 1 > out{};
+        half.unpack(std::array< uint8_t, 2 >{high, low}, out);
+        return compiled_format::to_double(out[0]);
+    };
+    REQUIRE(to_half(1.0) == 0x3C00);
+    REQUIRE(to_half(65504.0) == 0x7BFF);
+    REQUIRE(to_half(65520.0) == 0x7C00);
+    REQUIRE(to_half(1.0 + (1.0 / 2048)) == 0x3C00);
+    REQUIRE(to_half(1.0 + (3.0 / 2048)) == 0x3C02);
+    REQUIRE(to_half(1.0 / 16777216) == 0x0001);
+    REQUIRE(to_half(1.0 / 33554432) == 0x0000);
+    REQUIRE(to_half(3.0 / 33554432) == 0x0002);
+    REQUIRE(to_half(-1e300) == 0xFC00);
+    REQUIRE(from_half(0x3C, 0x00) == 1.0);
+    REQUIRE(from_half(0x7B, 0xFF) == 65504.0);
+    REQUIRE(from_half(0x00, 0x01) == 1.0 / 16777216);
+    REQUIRE(from_half(0x02, 0x00) == 1.0 / 32768);
+    REQUIRE(from_half(0xC1, 0x00) == -2.5);
+    REQUIRE(from_half(0x7C, 0x00) > 1e300);
+    REQUIRE(from_half(0x7E, 0x00) != from_half(0x7E, 0x00));
+}
+
+TEST_CASE("compiled format with little endian byte order", "[bitpacker::compile]")
+{
+    // the example from the bitstruct documentation: each value's bytes are swapped
+    const auto fmt = bitpacker::compile("u1u3u4s16<");
+    REQUIRE(fmt.valid());
+    const std::array< uint64_t, 4 > values{1, 2, 3, static_cast< uint64_t >(-4)};
+    std::array< uint8_t, 3 > packed{};
+    REQUIRE(fmt.pack(packed, values));
+    REQUIRE(packed == std::array< uint8_t, 3 >{0xA3, 0xFC, 0xFF});
+    std::array< uint64_t, 4 > unpacked{};
+    REQUIRE(fmt.unpack(packed, unpacked));
+    REQUIRE(unpacked == values);
+
+    const auto mixed = bitpacker::compile("u4u32<u16f32<");
+    const std::array< uint64_t, 4 > mixed_values{0xA, 0x01020304, 0x0001, bitpacker::compiled_format::from_double(1.0)};
+    std::array< uint8_t, 11 > mixed_packed{};
+    REQUIRE(mixed.pack_into(mixed_packed, 4, mixed_values));
+    REQUIRE(mixed_packed == std::array< uint8_t, 11 >{0x0A, 0x04, 0x03, 0x02, 0x01, 0x00, 0x80, 0xFC, 0x01, 0x00, 0x00});
+    std::array< uint64_t, 4 > mixed_unpacked{};
+    REQUIRE(mixed.unpack_from(mixed_packed, 4, mixed_unpacked));
+    REQUIRE(mixed_unpacked == mixed_values);
+}
+
+TEST_CASE("compiled format checks sizes", "[bitpacker::compile]")
+{
+    const auto fmt = bitpacker::compile("u8u8u8");
+    std::array< uint8_t, 3 > buffer{};
+    std::array< uint64_t, 2 > too_few{};
+    std::array< uint64_t, 3 > values{1, 2, 3};
+    REQUIRE_FALSE(fmt.pack(buffer, too_few));
+    REQUIRE_FALSE(fmt.pack_into(buffer, 1, values));
+    REQUIRE(fmt.pack(buffer, values));
+    REQUIRE(buffer == std::array< uint8_t, 3 >{1, 2, 3});
+    REQUIRE_FALSE(fmt.unpack(buffer, too_few));
+    REQUIRE_FALSE(bitpacker::compile("u8x").unpack(buffer, values));
+}
+
+TEST_CASE("compiled format items match get_type_array", "[bitpacker::compile]")
+{
+    constexpr auto expected = bitpacker::impl::get_type_array(BP_STRING("u4b1<s12[3]p3P2"));
+    const auto fmt = bitpacker::compile("u4b1<s12[3]p3P2");
+    const auto items = fmt.items();
+    REQUIRE(items.size() == expected.size());
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        REQUIRE(items[i].formatChar == expected[i].formatChar);
+        REQUIRE(items[i].count == expected[i].count);
+        REQUIRE(items[i].offset == expected[i].offset);
+        REQUIRE(items[i].endian == expected[i].endian);
+        REQUIRE(items[i].repeat == expected[i].repeat);
+    }
+}
+
+TEST_CASE("format cache parses each format once", "[bitpacker::format_cache]")
+{
+    bitpacker::format_cache cache(2);
+    REQUIRE(cache.capacity() == 2);
+
+    const auto a = cache.get("u4b1s11");
+    REQUIRE(a->valid());
+    REQUIRE(a->size() == 16);
+    REQUIRE(cache.get(std::string("u4b1s11")) == a);
+    REQUIRE(cache.stats().hits == 1);
+    REQUIRE(cache.stats().misses == 1);
+
+    const auto bad = cache.get("u4x3");
+    REQUIRE_FALSE(bad->valid());
+    REQUIRE(cache.stats().size == 2);
+
+    // "u4x3" is the least recently used and is dropped, "u4b1s11" stays
+    REQUIRE(cache.get("u4b1s11") == a);
+    const auto c = cache.get("u8");
+    REQUIRE(cache.stats().size == 2);
+    REQUIRE(cache.get("u4b1s11") == a);
+    REQUIRE(cache.get("u4x3") != bad);
+    REQUIRE(cache.stats().hits == 3);
+    REQUIRE(cache.stats().misses == 4);
+
+    // formats handed out stay usable after they leave the cache
+    REQUIRE(c->size() == 8);
+    cache.clear();
+    REQUIRE(cache.stats().size == 0);
+    REQUIRE(cache.stats().hits == 0);
+    REQUIRE(a->field_count() == 3);
+}
+
+TEST_CASE("format cache is thread safe", "[bitpacker::format_cache]")
+{
+    bitpacker::format_cache cache(4);
+    const std::array< std::string, 6 > formats{"u1", "u2", "u3", "u4", "u5", "u6"};
+    std::vector< std::thread > threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&cache, &formats, t] {
+            for (int i = 0; i < 1000; ++i) {
+                const auto &f = formats[static_cast< std::size_t >((i + t) % 6)];
+                const auto compiled = cache.get(f);
+                if (!compiled->valid() || compiled->size() != static_cast< bitpacker::size_type >(f[1] - '0')) {
+                    throw std::runtime_error("wrong format from cache");
+                }
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    const auto stats = cache.stats();
+    REQUIRE(stats.hits + stats.misses == 4000);
+    REQUIRE(stats.size == 4);
+}
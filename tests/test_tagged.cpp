@@ -0,0 +1,79 @@
+#include "test_common.hpp"
+#include "constexpr_helpers.h"
+#include <array>
+#include <variant>
+
+namespace {
+    constexpr auto status_fmt = BP_STRING("u12b1b1");
+    constexpr auto position_fmt = BP_STRING("s16s16");
+    constexpr auto name_fmt = BP_STRING("t24");
+    constexpr auto message_fmt = bitpacker::tagged(BP_STRING("u4p4"),
+                                                   bitpacker::alternative< 1 >(status_fmt),
+                                                   bitpacker::alternative< 2 >(position_fmt),
+                                                   bitpacker::alternative< 9 >(name_fmt));
+    using message_type = decltype(message_fmt)::value_type;
+}
+
+TEST_CASE("tagged format properties", "[bitpacker::tagged]")
+{
+    REQUIRE_STATIC(decltype(message_fmt)::tag_bits == 8);
+    REQUIRE_STATIC(decltype(message_fmt)::max_tag == 9);
+    REQUIRE_STATIC(decltype(message_fmt)::max_bits == 8 + 32);
+    REQUIRE_STATIC(std::variant_size_v< message_type > == 4);
+}
+
+TEST_CASE("tag values must fit in the tag field", "[bitpacker::tagged]")
+{
+    namespace bpimpl = bitpacker::impl;
+    // tagged(BP_STRING("u2"), alternative< 1 >(...), alternative< 5 >(...)) does not compile: 5 would be packed as 1
+    REQUIRE_STATIC(!bpimpl::fit_in_bits(std::array< bitpacker::size_type, 2 >{1, 5}, 2));
+    REQUIRE_STATIC(!bpimpl::fit_in_bits(std::array< bitpacker::size_type, 1 >{4}, 2));
+    REQUIRE_STATIC(bpimpl::fit_in_bits(std::array< bitpacker::size_type, 2 >{1, 3}, 2));
+    REQUIRE_STATIC(bpimpl::fit_in_bits(std::array< bitpacker::size_type, 1 >{~bitpacker::size_type{0}}, 64));
+    REQUIRE_STATIC(bpimpl::fit_in_bits(decltype(message_fmt)::tags, 4));
+    REQUIRE_STATIC(!bpimpl::fit_in_bits(decltype(message_fmt)::tags, 3));
+}
+
+TEST_CASE("unpack tagged format to a variant", "[bitpacker::tagged]")
+{
+    const auto status = bitpacker::pack(bitpacker::concat(BP_STRING("u4p4"), status_fmt), 1, 3300, true, false);
+    const auto status_value = bitpacker::unpack_variant(message_fmt, status);
+    REQUIRE(status_value.index() == 1);
+    REQUIRE(std::get< 1 >(status_value) == std::make_tuple(3300, true, false));
+
+    const auto position = bitpacker::pack(bitpacker::concat(BP_STRING("u4p4"), position_fmt), 2, -1000, 2000);
+    const auto position_value = bitpacker::unpack_variant(message_fmt, position);
+    REQUIRE(position_value.index() == 2);
+    REQUIRE(std::get< 2 >(position_value) == std::make_tuple(-1000, 2000));
+
+    const std::array< uint8_t, 5 > unknown{0x50, 0x12, 0x34, 0x56, 0x78};
+    REQUIRE(std::holds_alternative< std::monostate >(bitpacker::unpack_variant(message_fmt, unknown)));
+    const std::array< uint8_t, 5 > out_of_range{0xF0, 0x12, 0x34, 0x56, 0x78};
+    REQUIRE(std::holds_alternative< std::monostate >(bitpacker::unpack_variant(message_fmt, out_of_range)));
+}
+
+TEST_CASE("pack a variant with a tagged format", "[bitpacker::tagged]")
+{
+    const std::array< char, 3 > name{'a', 'b', 'c'};
+    const message_type value(std::in_place_index< 3 >, std::make_tuple(name));
+    const auto packed = bitpacker::pack_variant(message_fmt, value);
+    REQUIRE(packed == std::array< uint8_t, 5 >{0x90, 'a', 'b', 'c', 0x00});
+
+    const auto round_trip = bitpacker::unpack_variant(message_fmt, packed);
+    REQUIRE(round_trip.index() == 3);
+    REQUIRE(std::get< 0 >(std::get< 3 >(round_trip)) == name);
+
+    std::array< uint8_t, 6 > buffer{};
+    const message_type position(std::in_place_index< 2 >, std::make_tuple(int16_t{-2}, int16_t{3}));
+    REQUIRE(bitpacker::pack_variant_into(message_fmt, buffer, 4, position) == 40);
+    REQUIRE(bitpacker::unpack_variant_from(message_fmt, buffer, 4) == position);
+    REQUIRE(bitpacker::pack_variant_into(message_fmt, buffer, 0, message_type{}) == 0);
+}
+
+TEST_CASE("tagged formats work at compile time", "[bitpacker::tagged]")
+{
+    constexpr auto packed = bitpacker::pack_variant(message_fmt, message_type(std::in_place_index< 1 >, std::make_tuple(uint16_t{7}, false, true)));
+    constexpr auto value = bitpacker::unpack_variant(message_fmt, packed);
+    REQUIRE_STATIC(value.index() == 1);
+    REQUIRE_STATIC(std::get< 0 >(std::get< 1 >(value)) == 7);
+}
@@ -142,3 +142,155 @@ TEST_CASE("calculate format size in bytes with bit-endian changing", "[format]")
     REQUIRE_STATIC(bitpacker::calcbytes(BP_STRING("u4f16<b2s12t10r10f32p2P2"))  == byte_size);
     REQUIRE_STATIC(bitpacker::calcbytes(BP_STRING("u4<f16b2>s12t10r10f32p2P2")) == byte_size);
 }
+
+TEST_CASE("parse array items", "[format]")
+{
+    REQUIRE_STATIC(bpimpl::validate_format(BP_STRING("u4u12[5]b1")));
+    REQUIRE_STATIC(bpimpl::validate_format(BP_STRING("<s7[3]p2[2]<")));
+    REQUIRE_STATIC(!bpimpl::validate_format(BP_STRING("u12[0]")));
+    REQUIRE_STATIC(!bpimpl::validate_format(BP_STRING("u12[]")));
+    REQUIRE_STATIC(!bpimpl::validate_format(BP_STRING("u12[4")));
+
+    REQUIRE_STATIC(bpimpl::count_all_items(BP_STRING("u4u12[5]p2[2]b1")) == 4);
+    REQUIRE_STATIC(bpimpl::count_non_padding(BP_STRING("u4u12[5]p2[2]b1")) == 3);
+    REQUIRE_STATIC(bpimpl::get_type_array(BP_STRING("u4u12[5]b1"))[1].repeat == 5);
+    REQUIRE_STATIC(bpimpl::get_type_array(BP_STRING("u4u12[5]b1"))[1].count == 60);
+    REQUIRE_STATIC(bpimpl::element_bits(bpimpl::get_type_array(BP_STRING("u4u12[5]b1"))[1]) == 12);
+    REQUIRE_STATIC(bpimpl::get_type_array(BP_STRING("u4u12[5]b1"))[2].offset == 64);
+    REQUIRE_STATIC(bpimpl::get_type_array(BP_STRING("u4u12[5]b1"))[2].repeat == 0);
+    REQUIRE_STATIC(bitpacker::calcsize(BP_STRING("u4u12[5]b1")) == bitpacker::calcsize(BP_STRING("u4u12u12u12u12u12b1")));
+}
+
+TEST_CASE("concatenate formats", "[format]")
+{
+    constexpr auto header = BP_STRING("u3b1<u4");
+    constexpr auto payload = BP_STRING("u12[2]s6");
+    constexpr auto message = bitpacker::concat(header, payload);
+
+    REQUIRE_STATIC(equals(std::string_view(message.value()), "u3b1<u4>u12[2]s6"));
+    REQUIRE_STATIC(bitpacker::calcsize(message) == bitpacker::calcsize(header) + bitpacker::calcsize(payload));
+    REQUIRE_STATIC(bpimpl::count_non_padding(message) == 5);
+    REQUIRE_STATIC(bpimpl::get_type_array(message)[3].offset == 8);
+    REQUIRE_STATIC(bpimpl::get_type_array(message)[3].endian == bpimpl::Endian::big);
+
+    // formats that start with a bit order keep it, and the result can be concatenated again
+    constexpr auto nested = bitpacker::concat(message, BP_STRING("<p2b1"), BP_STRING("u5"));
+    REQUIRE_STATIC(equals(std::string_view(nested.value()), "u3b1<u4>u12[2]s6<p2b1>u5"));
+
+    const std::array< uint16_t, 2 > values{0xABC, 0x123};
+    const auto packed = bitpacker::pack(message, 5, true, 0x3, values, -7);
+    REQUIRE(packed == bitpacker::pack(BP_STRING("u3b1<u4>u12[2]s6"), 5, true, 0x3, values, -7));
+
+    std::array< uint8_t, bitpacker::calcbytes(message) > split{};
+    bitpacker::pack_into(header, split, 0, 5, true, 0x3);
+    bitpacker::pack_into(payload, split, bitpacker::calcsize(header), values, -7);
+    REQUIRE(packed == split);
+}
+
+TEST_CASE("format layout plan", "[format]")
+{
+    constexpr auto fmt = BP_STRING("u4p3<s12P2b1");
+    using layout = bpimpl::layout< std::remove_const_t< decltype(fmt) > >;
+    REQUIRE_STATIC(layout::item_count == 5);
+    REQUIRE_STATIC(layout::field_count == 3);
+    REQUIRE_STATIC(layout::padding_count == 2);
+    REQUIRE_STATIC(layout::bits == 22);
+    REQUIRE_STATIC(layout::byte_order == bpimpl::Endian::big);
+    REQUIRE_STATIC(!layout::has_counted);
+    REQUIRE_STATIC(!layout::has_groups);
+
+    // fields and padding keep their offsets in the whole format
+    REQUIRE_STATIC(layout::fields[1].formatChar == 's');
+    REQUIRE_STATIC(layout::fields[1].offset == 7);
+    REQUIRE_STATIC(layout::fields[1].endian == bpimpl::Endian::little);
+    REQUIRE_STATIC(layout::fields[2].offset == 21);
+    REQUIRE_STATIC(layout::padding[0].offset == 4);
+    REQUIRE_STATIC(layout::padding[1].formatChar == 'P');
+    REQUIRE_STATIC(layout::types[3].offset == layout::padding[1].offset);
+
+    REQUIRE_STATIC(bpimpl::has_counted_item(BP_STRING("u8s4[#0]")));
+    REQUIRE_STATIC(bpimpl::has_optional_group(BP_STRING("b1{#0:u8}")));
+}
+
+TEST_CASE("format with many fields", "[format]")
+{
+    // 1200 items: field types are looked up in the layout plan one at a time, never through a tuple of all of them
+    #define BP_TEST_FIELDS10 "u4s3b1p2u12u7s9u8u1p1"
+    #define BP_TEST_FIELDS100 BP_TEST_FIELDS10 BP_TEST_FIELDS10 BP_TEST_FIELDS10 BP_TEST_FIELDS10 BP_TEST_FIELDS10 \
+                              BP_TEST_FIELDS10 BP_TEST_FIELDS10 BP_TEST_FIELDS10 BP_TEST_FIELDS10 BP_TEST_FIELDS10
+    constexpr auto fmt = BP_STRING(BP_TEST_FIELDS100 BP_TEST_FIELDS100 BP_TEST_FIELDS100 BP_TEST_FIELDS100
+                                   BP_TEST_FIELDS100 BP_TEST_FIELDS100 BP_TEST_FIELDS100 BP_TEST_FIELDS100
+                                   BP_TEST_FIELDS100 BP_TEST_FIELDS100 BP_TEST_FIELDS100 BP_TEST_FIELDS100);
+    #undef BP_TEST_FIELDS100
+    #undef BP_TEST_FIELDS10
+    using layout = bpimpl::layout< std::remove_const_t< decltype(fmt) > >;
+    REQUIRE_STATIC(layout::item_count == 1200);
+    REQUIRE_STATIC(layout::field_count == 960);
+    REQUIRE_STATIC(bitpacker::calcsize(fmt) == 120 * 48);
+    REQUIRE_STATIC(layout::fields[959].offset == (119 * 48) + 46);
+    using field = bpimpl::field_type< std::remove_const_t< decltype(fmt) >, 957 >;
+    REQUIRE_STATIC((std::is_same< field::return_type, int16_t >::value));
+
+    std::array< uint8_t, bitpacker::calcbytes(fmt) > packed{};
+    std::array< uint64_t, 960 > values{};
+    for (size_t i = 0; i < values.size(); ++i) {
+        values[i] = i % 8 == 7 ? 1U : i % 3;
+    }
+    std::apply([&](auto... v) { bitpacker::pack_into(fmt, packed, 0, v...); }, values);
+
+    auto v = bitpacker::view(fmt, packed);
+    REQUIRE(v.get< 0 >() == 0);
+    REQUIRE(v.get< 1 >() == 1);
+    REQUIRE(v.get< 2 >() == true);
+    REQUIRE(v.get< 950 >() == 950 % 3);
+    REQUIRE(v.get< 959 >() == 1);
+
+    std::array< uint64_t, 960 > unpacked{};
+    std::apply([&](auto &... out) { bitpacker::unpack_into(fmt, packed, out...); }, unpacked);
+    REQUIRE(unpacked[958] == values[958]);
+}
+
+TEST_CASE("format with thousands of fields", "[format]")
+{
+    // 2500 items, 2000 of them non-padding: every entry point that takes a full-frame format compiles
+    #define BP_TEST_FIELDS10 "u4s3b1p2u12u7s9u8u1p1"
+    #define BP_TEST_FIELDS100 BP_TEST_FIELDS10 BP_TEST_FIELDS10 BP_TEST_FIELDS10 BP_TEST_FIELDS10 BP_TEST_FIELDS10 \
+                              BP_TEST_FIELDS10 BP_TEST_FIELDS10 BP_TEST_FIELDS10 BP_TEST_FIELDS10 BP_TEST_FIELDS10
+    #define BP_TEST_FIELDS500 BP_TEST_FIELDS100 BP_TEST_FIELDS100 BP_TEST_FIELDS100 BP_TEST_FIELDS100 BP_TEST_FIELDS100
+    constexpr auto fmt = BP_STRING(BP_TEST_FIELDS500 BP_TEST_FIELDS500 BP_TEST_FIELDS500 BP_TEST_FIELDS500 BP_TEST_FIELDS500);
+    #undef BP_TEST_FIELDS500
+    #undef BP_TEST_FIELDS100
+    #undef BP_TEST_FIELDS10
+    REQUIRE_STATIC(bpimpl::count_non_padding(fmt) == 2000);
+    REQUIRE_STATIC(bitpacker::calcsize(fmt) == 250 * 48);
+
+    std::array< uint64_t, 2000 > values{};
+    for (size_t i = 0; i < values.size(); ++i) {
+        values[i] = i % 8 == 2 || i % 8 == 7 ? 1U : i % 3;  // 'b1' and 'u1' fields hold 1
+    }
+    std::array< uint8_t, bitpacker::calcbytes(fmt) > packed{};
+    std::apply([&](auto... v) { bitpacker::pack_into(fmt, packed, 0, v...); }, values);
+    REQUIRE(std::apply([&](auto... v) { return bitpacker::pack(fmt, v...); }, values) == packed);
+
+    const auto record = bitpacker::unpack(fmt, packed);
+    REQUIRE_STATIC((std::is_same< std::remove_const_t< decltype(record) >, bitpacker::large_record< std::remove_const_t< decltype(fmt) > > >::value));
+    REQUIRE(bitpacker::get< 0 >(record) == 0);
+    REQUIRE(bitpacker::get< 1 >(record) == 1);
+    REQUIRE(bitpacker::get< 1999 >(record) == 1);
+    REQUIRE(bitpacker::get< 1996 >(record) == values[1996]);
+
+    std::array< uint8_t, bitpacker::calcbytes(fmt) + 1 > shifted{};
+    std::apply([&](auto... v) { bitpacker::pack_into(fmt, shifted, 3, v...); }, values);
+    REQUIRE(bitpacker::unpack_from(fmt, shifted, 3) == record);
+
+    std::array< uint64_t, 2000 > unpacked{};
+    std::apply([&](auto &... out) { bitpacker::unpack_into(fmt, packed, out...); }, unpacked);
+    REQUIRE(unpacked == values);
+    unpacked = {};
+    std::apply([&](auto &... out) { bitpacker::unpack_from_into(fmt, shifted, 3, out...); }, unpacked);
+    REQUIRE(unpacked == values);
+
+    REQUIRE(bitpacker::view(fmt, packed).get< 1998 >() == values[1998]);
+    bitpacker::mutable_view(fmt, packed).set< 1998 >(2);
+    REQUIRE(bitpacker::get< 1998 >(bitpacker::unpack(fmt, packed)) == 2);
+}
@@ -348,3 +348,22 @@ TEST_CASE("Unpack 64-bit value across boundaries", "[unpack]") {
     REQUIRE( bitpacker::extract<uint64_t>(input1, 4, 64) == expected);
     REQUIRE( bitpacker::extract<uint64_t>(input2, 4, 64) == expected);
 }
+
+TEST_CASE("Bulk extract of bytes matches per-byte extract", "[unpack]") {
+    std::array<uint8_t, 24> input{};
+    for (size_t i = 0; i < input.size(); ++i) {
+        input[i] = static_cast<uint8_t>(0x3B * (i + 1));
+    }
+
+    for (size_t offset = 0; offset < 12; ++offset) {
+        for (size_t count = 0; count <= 20; ++count) {
+            std::array<uint8_t, 20> bulk{};
+            std::array<uint8_t, 20> bytewise{};
+            bitpacker::impl::extract_bytes(input, offset, bulk.data(), count);
+            for (size_t i = 0; i < count; ++i) {
+                bytewise[i] = bitpacker::extract<uint8_t>(input, offset + (i * 8), 8);
+            }
+            REQUIRE(bulk == bytewise);
+        }
+    }
+}
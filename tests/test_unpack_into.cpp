@@ -0,0 +1,183 @@
+#include "test_common.hpp"
+#include "constexpr_helpers.h"
+#include <array>
+#include <vector>
+
+namespace {
+    struct Message {
+        uint8_t type;
+        bool flag;
+        int16_t value;
+        std::array< uint8_t, 4 > payload;
+    };
+}
+
+TEST_CASE("unpack into separate outputs", "[bitpacker::unpack_into]")
+{
+    constexpr auto fmt = BP_STRING("u4p3b1s12<u9r32");
+    const std::array< uint8_t, 4 > raw{0xDE, 0xAD, 0xBE, 0xEF};
+    const auto packed = bitpacker::pack(fmt, 0xA, true, -300, 0x1F3, raw);
+
+    uint8_t a = 0;
+    bool b = false;
+    int32_t c = 0; // any type assignable from the field type works
+    uint16_t d = 0;
+    std::array< uint8_t, 4 > e{};
+    bitpacker::unpack_into(fmt, packed, a, b, c, d, e);
+
+    REQUIRE(a == 0xA);
+    REQUIRE(b == true);
+    REQUIRE(c == -300);
+    REQUIRE(d == 0x1F3);
+    REQUIRE(e == raw);
+}
+
+TEST_CASE("unpack into an aggregate", "[bitpacker::unpack_into]")
+{
+    constexpr auto fmt = BP_STRING("u4b1P3s16r28");
+    const std::array< uint8_t, 4 > raw{0x12, 0x34, 0x56, 0x70};
+    std::array< uint8_t, 8 > packed{};
+    bitpacker::pack_into(fmt, packed, 3, 7, true, -12345, raw);
+
+    Message msg{};
+    bitpacker::unpack_from_into(fmt, packed, 3, msg);
+    REQUIRE(msg.type == 7);
+    REQUIRE(msg.flag == true);
+    REQUIRE(msg.value == -12345);
+    REQUIRE(msg.payload == raw);
+}
+
+TEST_CASE("unpack text into caller storage", "[bitpacker::unpack_into]")
+{
+    constexpr auto fmt = BP_STRING("u3<t16");
+    const auto packed = bitpacker::pack(fmt, 5, "hi");
+
+    uint8_t a = 0;
+    char text[2] = {};
+    bitpacker::unpack_into(fmt, packed, a, text);
+    REQUIRE(a == 5);
+    REQUIRE(text[0] == 'h');
+    REQUIRE(text[1] == 'i');
+}
+
+TEST_CASE("a single raw or text field unpacks into an array", "[bitpacker::unpack_into]")
+{
+    const auto text = bitpacker::pack(BP_STRING("t128"), "sixteen chars!!!");
+    char out[16] = {};
+    bitpacker::unpack_into(BP_STRING("t128"), text, out);
+    REQUIRE(std::equal(std::begin(out), std::end(out), "sixteen chars!!!"));
+
+    const std::array< uint8_t, 2 > raw{0xC0, 0xDE};
+    const auto packed = bitpacker::pack(BP_STRING("r16"), raw);
+    std::array< uint8_t, 4 > larger{};
+    bitpacker::unpack_into(BP_STRING("r16"), packed, larger);
+    REQUIRE(larger == std::array< uint8_t, 4 >{0xC0, 0xDE, 0x00, 0x00});
+
+    REQUIRE_STATIC(!bitpacker::impl::is_member_aggregate< char[16] >);
+    REQUIRE_STATIC((!bitpacker::impl::is_member_aggregate< std::array< uint8_t, 4 > >));
+    REQUIRE_STATIC(bitpacker::impl::is_member_aggregate< Message >);
+}
+
+TEST_CASE("fixed size outputs must hold the whole field", "[bitpacker::unpack_into]")
+{
+    namespace bpimpl = bitpacker::impl;
+    REQUIRE_STATIC(bpimpl::static_extent< char[3] >::value == 3);
+    REQUIRE_STATIC((bpimpl::static_extent< std::array< uint8_t, 2 > >::value == 2));
+    REQUIRE_STATIC(bpimpl::static_extent< std::vector< uint8_t > >::value == 0);
+    REQUIRE_STATIC(bpimpl::can_hold< char[2] >(2));
+    REQUIRE_STATIC(!bpimpl::can_hold< char[2] >(3));             // 't20' needs 3 chars, would not compile
+    REQUIRE_STATIC((!bpimpl::can_hold< const std::array< uint16_t, 2 > >(3)));
+    REQUIRE_STATIC(bpimpl::can_hold< std::vector< char > >(3));  // size only known at runtime
+}
+
+namespace {
+    struct Reading {
+        uint16_t voltage;
+        bool error;
+        bool other;
+        uint16_t pressure;
+        int32_t time;
+    };
+}
+
+template <>
+struct bitpacker::format_binding< Reading > {
+    static constexpr auto format() { return BP_STRING("u12b1b1p2u14s24"); }
+};
+
+TEST_CASE("get and store for an aggregate bound to a format", "[bitpacker::binding]")
+{
+    const Reading r{3300, true, false, 4500, -1676479};
+    std::array< uint8_t, 8 > buffer{};
+    buffer.fill(0xFF);
+    bitpacker::store(buffer, 4, r);
+
+    std::array< uint8_t, 8 > expected{};
+    expected.fill(0xFF);
+    bitpacker::pack_into(BP_STRING("u12b1b1p2u14s24"), expected, 4, r.voltage, r.error, r.other, r.pressure, r.time);
+    REQUIRE(buffer == expected);
+
+    const auto back = bitpacker::get< Reading >(buffer, 4);
+    REQUIRE(back.voltage == r.voltage);
+    REQUIRE(back.error == r.error);
+    REQUIRE(back.other == r.other);
+    REQUIRE(back.pressure == r.pressure);
+    REQUIRE(back.time == r.time);
+}
+
+namespace {
+    struct HandReading {
+        uint16_t voltage;
+        bool error;
+        bool other;
+        uint16_t pressure;
+        int32_t time;
+    };
+}
+
+// the same layout as Reading, written by hand like the README example
+template <>
+constexpr void bitpacker::store(span< byte_type > buffer, size_type offset, HandReading value) noexcept
+{
+    insert(buffer, offset + 0, 12, value.voltage);
+    insert(buffer, offset + 12, 1, static_cast< uint8_t >(value.error));
+    insert(buffer, offset + 13, 1, static_cast< uint8_t >(value.other));
+    insert(buffer, offset + 14, 2, uint8_t{0});
+    insert(buffer, offset + 16, 14, value.pressure);
+    insert(buffer, offset + 30, 24, static_cast< uint32_t >(value.time));
+}
+
+template <>
+constexpr HandReading bitpacker::get(span< const byte_type > buffer, size_type offset) noexcept
+{
+    return {extract< uint16_t >(buffer, offset + 0, 12),
+            extract< uint8_t >(buffer, offset + 12, 1) != 0,
+            extract< uint8_t >(buffer, offset + 13, 1) != 0,
+            extract< uint16_t >(buffer, offset + 16, 14),
+            impl::sign_extend< uint32_t, 24 >(extract< uint32_t >(buffer, offset + 30, 24))};
+}
+
+namespace {
+    constexpr bool bound_matches_hand_written(const bitpacker::size_type offset)
+    {
+        std::array< uint8_t, 8 > bound{0xA5, 0xA5, 0xA5, 0xA5, 0xA5, 0xA5, 0xA5, 0xA5};
+        std::array< uint8_t, 8 > hand = bound;
+        bitpacker::store(bound, offset, Reading{3300, true, false, 4500, -1676479});
+        bitpacker::store(hand, offset, HandReading{3300, true, false, 4500, -1676479});
+        for (size_t i = 0; i < bound.size(); ++i) {
+            if (bound[i] != hand[i]) {
+                return false;
+            }
+        }
+        const auto a = bitpacker::get< Reading >(bound, offset);
+        const auto b = bitpacker::get< HandReading >(hand, offset);
+        return a.voltage == b.voltage && a.error == b.error && a.other == b.other && a.pressure == b.pressure && a.time == b.time;
+    }
+}
+
+TEST_CASE("bound aggregates match hand written get and store", "[bitpacker::binding]")
+{
+    REQUIRE_STATIC(bound_matches_hand_written(0));
+    REQUIRE_STATIC(bound_matches_hand_written(4));
+    REQUIRE_STATIC(bound_matches_hand_written(9));
+}
@@ -0,0 +1,129 @@
+#define CATCH_CONFIG_ENABLE_TUPLE_STRINGMAKER
+#include "test_common.hpp"
+#include "constexpr_helpers.h"
+#include <array>
+#include <algorithm>
+
+TEST_CASE("view decodes single fields", "[bitpacker::view]")
+{
+    constexpr auto fmt = BP_STRING("u4p3b1s12<u9t16");
+    constexpr auto packed = bitpacker::pack(fmt, 0xA, true, -300, 0x1F3, "hi");
+    const auto v = bitpacker::view(fmt, packed);
+
+    REQUIRE(v.get< 0 >() == 0xA);
+    REQUIRE(v.get< 1 >() == true);
+    REQUIRE(v.get< 2 >() == -300);
+    REQUIRE(bitpacker::get< 3 >(v) == 0x1F3);
+    REQUIRE(equals(v.get< 4 >().get(), std::array< char, 2 >{'h', 'i'}));
+    REQUIRE(equals(bitpacker::unpack(fmt, packed), std::make_tuple(v.get< 0 >().get(), v.get< 1 >().get(), v.get< 2 >().get(), v.get< 3 >().get(), v.get< 4 >().get())));
+}
+
+TEST_CASE("view at a bit offset", "[bitpacker::view]")
+{
+    constexpr auto fmt = BP_STRING("u4s12");
+    std::array< uint8_t, 3 > packed{};
+    bitpacker::pack_into(fmt, packed, 5, 9, -2000);
+    const auto v = bitpacker::view(fmt, packed, 5);
+
+    REQUIRE(v.get< 0 >() == 9);
+    REQUIRE(v.get< 1 >() == -2000);
+}
+
+TEST_CASE("view supports structured bindings", "[bitpacker::view]")
+{
+    constexpr auto fmt = BP_STRING("u4b1s12");
+    constexpr auto packed = bitpacker::pack(fmt, 3, false, 1234);
+    const auto [type, flag, value] = bitpacker::view(fmt, packed);
+
+    STATIC_REQUIRE(std::is_same< std::remove_const_t< decltype(type) >::value_type, uint8_t >::value);
+    STATIC_REQUIRE(std::is_same< std::remove_const_t< decltype(value) >::value_type, int16_t >::value);
+    REQUIRE(type == 3);
+    REQUIRE(flag == false);
+    REQUIRE(value == 1234);
+    const int16_t decoded = value;
+    REQUIRE(decoded == 1234);
+}
+
+namespace {
+    // only the first byte of a "u8s16" record: decoding field 1 would read past the end of the buffer,
+    // which is not allowed in a constant expression
+    constexpr uint8_t first_binding()
+    {
+        constexpr auto fmt = BP_STRING("u8s16");
+        constexpr std::array< uint8_t, 1 > truncated{0x2A};
+        const auto [type, unused] = bitpacker::view(fmt, truncated);
+        static_cast< void >(unused);
+        return type;
+    }
+}
+
+TEST_CASE("structured bindings only decode the fields that are read", "[bitpacker::view]")
+{
+    REQUIRE_STATIC(first_binding() == 0x2A);
+}
+
+TEST_CASE("mutable view sets single fields", "[bitpacker::view]")
+{
+    constexpr auto fmt = BP_STRING("u4P3b1s12<u9r8");
+    const std::array< uint8_t, 1 > raw{0x5C};
+    auto packed = bitpacker::pack(fmt, 0xA, true, -300, 0x1F3, raw);
+    auto v = bitpacker::mutable_view(fmt, packed);
+
+    v.set< 2 >(1000);
+    REQUIRE(packed == bitpacker::pack(fmt, 0xA, true, 1000, 0x1F3, raw));
+
+    v.field< 0 >() = 3;
+    v.field< 1 >() = false;
+    v.field< 3 >() = 0x0F0;
+    REQUIRE(packed == bitpacker::pack(fmt, 3, false, 1000, 0x0F0, raw));
+    REQUIRE(v.get< 3 >() == 0x0F0);
+    const uint16_t read_back = v.field< 3 >();
+    REQUIRE(read_back == 0x0F0);
+
+    // copying between fields copies the value, not the proxy
+    v.field< 0 >() = v.field< 3 >();
+    REQUIRE(bitpacker::view(fmt, packed).get< 0 >() == 0x0);
+}
+
+TEST_CASE("mutable view only touches the field's bits", "[bitpacker::view]")
+{
+    constexpr auto fmt = BP_STRING("u3u7u6");
+    std::array< uint8_t, 4 > packed{0xFF, 0xFF, 0xFF, 0xFF};
+    bitpacker::mutable_view(fmt, packed, 4).set< 1 >(0);
+
+    // field 1 is bits [7, 14)
+    REQUIRE(packed == std::array< uint8_t, 4 >{0b11111110, 0b00000011, 0xFF, 0xFF});
+}
+
+TEST_CASE("view byte aligned raw and text fields in place", "[bitpacker::view]")
+{
+    constexpr auto fmt = BP_STRING("u4p4r32t40");
+    const std::array< uint8_t, 4 > raw{0xDE, 0xAD, 0xBE, 0xEF};
+    auto packed = bitpacker::pack(fmt, 0xA, raw, "hello");
+
+    const auto v = bitpacker::view(fmt, packed);
+    const auto payload = v.bytes< 1 >();
+    REQUIRE(payload.data() == packed.data() + 1);
+    REQUIRE(payload.size() == 4);
+    REQUIRE(std::equal(payload.begin(), payload.end(), raw.begin()));
+    REQUIRE(v.text< 2 >() == "hello");
+
+    const auto mv = bitpacker::mutable_view(fmt, packed);
+    mv.bytes< 2 >()[0] = 'j';
+    REQUIRE(v.text< 2 >() == "jello");
+}
+
+TEST_CASE("views that don't start on a byte boundary have no byte fields", "[bitpacker::view]")
+{
+    constexpr auto fmt = BP_STRING("u4p4r16");
+    std::array< uint8_t, 4 > packed{};
+    bitpacker::pack_into(fmt, packed, 3, 0xA, std::array< uint8_t, 2 >{0x12, 0x34});
+
+    REQUIRE(bitpacker::view(fmt, packed, 3).bytes< 1 >().empty());
+    REQUIRE(bitpacker::mutable_view(fmt, packed, 3).bytes< 1 >().empty());
+    REQUIRE(bitpacker::view(fmt, packed, 3).get< 1 >() == std::array< uint8_t, 2 >{0x12, 0x34});
+
+    // the field must also fit in the buffer
+    REQUIRE(bitpacker::view(fmt, packed, 16).bytes< 1 >().empty());
+    REQUIRE(bitpacker::view(fmt, packed, 8).bytes< 1 >().size() == 2);
+}
@@ -0,0 +1,480 @@
+/**
+ *  BITPACKER
+ *  type-safe and low boilerplate bit-level serialization
+ *  https://github.com/CrustyAuklet/bitpacker
+ *
+ *  Copyright 2020 Ethan Slattery
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+/**
+ * bitpacker_gen: generate pack/unpack code for bit-level messages described in a schema file.
+ *
+ * usage: bitpacker_gen <schema file> <output header>
+ *
+ * Schema syntax, one statement per line, `#` starts a comment:
+ *
+ *     namespace telemetry          // optional, namespace of the generated code (may be nested with ::)
+ *     message MessageData          // starts a message, which becomes a struct
+ *         voltage   u12            // field name and a format string item: u, s, b, p or P and a width of 1 to 64
+ *         _         p2             // padding fields are named `_` and are not members of the struct
+ *         samples   <u4[3]         // `<` is least significant bit first, `>` (the default) most significant bit first
+ *     end
+ *
+ * For each message the header has a struct with one member per non-padding field, `pack_into()` and
+ * `unpack_from()` overloads and `bitpacker::get<T>`/`bitpacker::store<T>` specializations. The functions are
+ * fully unrolled and neighbouring fields are coalesced into words of up to 64 bits, so each word is one
+ * `bitpacker::extract()` or `bitpacker::insert()` call.
+ */
+
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+    struct field {
+        std::string name;
+        char type = 'u';
+        unsigned bits = 0;
+        unsigned repeat = 0;     //< 0 for a single value, otherwise the number of array elements
+        bool lsb_first = false;
+    };
+
+    struct message {
+        std::string name;
+        std::vector< field > fields;
+        unsigned long long bits = 0;
+    };
+
+    struct schema {
+        std::string ns;
+        std::vector< message > messages;
+    };
+
+    /// one value of a field, or one element of an array field, at a bit offset from the start of the message
+    struct element {
+        std::string member;      //< expression for the member, empty for padding
+        const field *f;
+        unsigned long long offset;
+    };
+
+    bool is_identifier(const std::string &s)
+    {
+        if (s.empty() || std::isdigit(static_cast< unsigned char >(s[0]))) {
+            return false;
+        }
+        for (const char c : s) {
+            if (!std::isalnum(static_cast< unsigned char >(c)) && c != '_') {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool is_namespace(const std::string &s)
+    {
+        std::string::size_type start = 0;
+        for (;;) {
+            const auto end = s.find("::", start);
+            if (!is_identifier(s.substr(start, end == std::string::npos ? std::string::npos : end - start))) {
+                return false;
+            }
+            if (end == std::string::npos) {
+                return true;
+            }
+            start = end + 2;
+        }
+    }
+
+    /// parse a single format string item like `u12`, `<s7` or `u4[3]`. Returns an error message, or an empty string.
+    std::string parse_type(const std::string &s, field &f)
+    {
+        std::string::size_type pos = 0;
+        if (pos < s.size() && (s[pos] == '<' || s[pos] == '>')) {
+            f.lsb_first = s[pos] == '<';
+            ++pos;
+        }
+        if (pos == s.size()) {
+            return "missing field type";
+        }
+        f.type = s[pos++];
+        if (f.type != 'u' && f.type != 's' && f.type != 'b' && f.type != 'p' && f.type != 'P') {
+            return std::string("unsupported field type '") + f.type + "', expected one of u, s, b, p or P";
+        }
+
+        const auto number = [&s, &pos](unsigned &value) {
+            const auto first = pos;
+            unsigned long long v = 0;
+            for (; pos < s.size() && std::isdigit(static_cast< unsigned char >(s[pos])) && v <= 0xFFFF; ++pos) {
+                v = (v * 10) + static_cast< unsigned >(s[pos] - '0');
+            }
+            value = static_cast< unsigned >(v);
+            return pos != first && v != 0 && v <= 0xFFFF;
+        };
+
+        if (!number(f.bits) || f.bits > 64) {
+            return "field width must be between 1 and 64";
+        }
+        if (pos < s.size() && s[pos] == '[') {
+            ++pos;
+            if (!number(f.repeat) || pos == s.size() || s[pos] != ']') {
+                return "array length must be a number between 1 and 65535, like u4[3]";
+            }
+            ++pos;
+        }
+        if (pos != s.size()) {
+            return "unexpected characters after the field type";
+        }
+        return {};
+    }
+
+    bool parse_schema(std::istream &in, const std::string &filename, schema &out)
+    {
+        std::string line;
+        unsigned line_no = 0;
+        message *current = nullptr;
+        const auto error = [&filename, &line_no](const std::string &what) {
+            std::cerr << filename << ":" << line_no << ": error: " << what << "\n";
+            return false;
+        };
+
+        while (std::getline(in, line)) {
+            ++line_no;
+            const auto comment = line.find('#');
+            if (comment != std::string::npos) {
+                line.erase(comment);
+            }
+            std::istringstream words(line);
+            std::string first;
+            std::string second;
+            std::string extra;
+            if (!(words >> first)) {
+                continue;
+            }
+            words >> second;
+            if (words >> extra) {
+                return error("unexpected '" + extra + "'");
+            }
+
+            if (current == nullptr) {
+                if (first == "namespace") {
+                    if (!out.ns.empty() || !out.messages.empty()) {
+                        return error("the namespace must be given once, before the first message");
+                    }
+                    if (!is_namespace(second)) {
+                        return error("'" + second + "' is not a valid namespace name");
+                    }
+                    out.ns = second;
+                }
+                else if (first == "message") {
+                    if (!is_identifier(second)) {
+                        return error("'" + second + "' is not a valid message name");
+                    }
+                    for (const auto &m : out.messages) {
+                        if (m.name == second) {
+                            return error("duplicate message '" + second + "'");
+                        }
+                    }
+                    out.messages.push_back(message{second, {}, 0});
+                    current = &out.messages.back();
+                }
+                else {
+                    return error("expected 'namespace' or 'message', got '" + first + "'");
+                }
+                continue;
+            }
+
+            if (first == "end" && second.empty()) {
+                if (current->fields.empty()) {
+                    return error("message '" + current->name + "' has no fields");
+                }
+                current = nullptr;
+                continue;
+            }
+
+            field f;
+            f.name = first;
+            if (second.empty()) {
+                return error("field '" + first + "' has no type");
+            }
+            const auto type_error = parse_type(second, f);
+            if (!type_error.empty()) {
+                return error(type_error);
+            }
+            const bool padding = f.type == 'p' || f.type == 'P';
+            if (padding != (f.name == "_")) {
+                return error(padding ? "padding fields must be named '_'" : "only padding fields can be named '_'");
+            }
+            if (!padding) {
+                if (!is_identifier(f.name)) {
+                    return error("'" + f.name + "' is not a valid field name");
+                }
+                for (const auto &other : current->fields) {
+                    if (other.name == f.name) {
+                        return error("duplicate field '" + f.name + "'");
+                    }
+                }
+            }
+            current->bits += static_cast< unsigned long long >(f.bits) * (f.repeat != 0 ? f.repeat : 1);
+            current->fields.push_back(f);
+        }
+
+        if (current != nullptr) {
+            return error("message '" + current->name + "' is missing 'end'");
+        }
+        if (out.messages.empty()) {
+            return error("no messages in schema");
+        }
+        return true;
+    }
+
+    std::string value_type(const field &f)
+    {
+        if (f.type == 'b') {
+            return "bool";
+        }
+        const unsigned width = f.bits <= 8 ? 8 : f.bits <= 16 ? 16 : f.bits <= 32 ? 32 : 64;
+        return std::string(f.type == 's' ? "int" : "uint") + std::to_string(width) + "_t";
+    }
+
+    std::string member_type(const field &f)
+    {
+        if (f.repeat != 0) {
+            return "std::array< " + value_type(f) + ", " + std::to_string(f.repeat) + " >";
+        }
+        return value_type(f);
+    }
+
+    std::string mask(unsigned bits)
+    {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "0x%llXULL", bits >= 64 ? ~0ULL : (1ULL << bits) - 1);
+        return buf;
+    }
+
+    std::string format_string(const message &m)
+    {
+        std::string fmt;
+        bool lsb = false;
+        for (const auto &f : m.fields) {
+            if (f.lsb_first != lsb) {
+                fmt += f.lsb_first ? '<' : '>';
+                lsb = f.lsb_first;
+            }
+            fmt += f.type + std::to_string(f.bits);
+            if (f.repeat != 0) {
+                fmt += "[" + std::to_string(f.repeat) + "]";
+            }
+        }
+        return fmt;
+    }
+
+    /// split the message into words of at most 64 bits, each made of whole elements
+    std::vector< std::vector< element > > coalesce(const message &m)
+    {
+        std::vector< std::vector< element > > words;
+        unsigned word_bits = 64;
+        unsigned long long offset = 0;
+        for (const auto &f : m.fields) {
+            const unsigned count = f.repeat != 0 ? f.repeat : 1;
+            for (unsigned i = 0; i < count; ++i, offset += f.bits) {
+                if (word_bits + f.bits > 64) {
+                    words.emplace_back();
+                    word_bits = 0;
+                }
+                std::string member;
+                if (f.name != "_") {
+                    member = "v." + f.name + (f.repeat != 0 ? "[" + std::to_string(i) + "]" : "");
+                }
+                words.back().push_back(element{member, &f, offset});
+                word_bits += f.bits;
+            }
+        }
+        return words;
+    }
+
+    unsigned word_size(const std::vector< element > &word)
+    {
+        unsigned bits = 0;
+        for (const auto &e : word) {
+            bits += e.f->bits;
+        }
+        return bits;
+    }
+
+    void write_unpack(std::ostream &out, const message &m)
+    {
+        out << "    /// unpack a `" << m.name << "` from `buffer` starting at bit `offset`\n"
+            << "    constexpr void unpack_from(bitpacker::span< const bitpacker::byte_type > buffer, bitpacker::size_type offset, "
+            << m.name << " &v) noexcept\n"
+            << "    {\n";
+        for (const auto &word : coalesce(m)) {
+            const unsigned bits = word_size(word);
+            bool used = false;
+            for (const auto &e : word) {
+                used = used || !e.member.empty();
+            }
+            if (!used) {
+                continue;
+            }
+            out << "        {\n"
+                << "            const auto w = bitpacker::extract< uint64_t >(buffer, offset + " << word.front().offset << ", " << bits << ");\n";
+            unsigned end = 0;
+            for (const auto &e : word) {
+                end += e.f->bits;
+                if (e.member.empty()) {
+                    continue;
+                }
+                const unsigned shift = bits - end;
+                std::string raw = shift == 0 ? std::string("w") : "(w >> " + std::to_string(shift) + "U)";
+                if (e.f->bits < 64) {
+                    raw = "(" + raw + " & " + mask(e.f->bits) + ")";
+                }
+                if (e.f->lsb_first) {
+                    raw = "bitpacker::impl::reverse_bits< uint64_t, " + std::to_string(e.f->bits) + " >" + (raw.front() == '(' ? raw : "(" + raw + ")");
+                }
+                std::string value;
+                if (e.f->type == 'b') {
+                    value = raw + " != 0";
+                }
+                else if (e.f->type == 's') {
+                    value = "static_cast< " + value_type(*e.f) + " >(bitpacker::impl::sign_extend< uint64_t, " + std::to_string(e.f->bits) + " >" + (raw.front() == '(' ? raw : "(" + raw + ")") + ")";
+                }
+                else {
+                    value = "static_cast< " + value_type(*e.f) + " >" + (raw.front() == '(' ? raw : "(" + raw + ")");
+                }
+                out << "            " << e.member << " = " << value << ";\n";
+            }
+            out << "        }\n";
+        }
+        out << "    }\n\n";
+    }
+
+    void write_pack(std::ostream &out, const message &m)
+    {
+        out << "    /// pack `v` into `buffer` starting at bit `offset`\n"
+            << "    constexpr void pack_into(bitpacker::span< bitpacker::byte_type > buffer, bitpacker::size_type offset, const "
+            << m.name << " &v) noexcept\n"
+            << "    {\n";
+        for (const auto &word : coalesce(m)) {
+            const unsigned bits = word_size(word);
+            out << "        {\n"
+                << "            uint64_t w = 0;\n";
+            unsigned end = 0;
+            for (const auto &e : word) {
+                end += e.f->bits;
+                const unsigned shift = bits - end;
+                std::string value;
+                if (e.f->type == 'p') {
+                    continue;
+                }
+                if (e.f->type == 'P') {
+                    value = mask(e.f->bits);
+                }
+                else {
+                    value = e.f->type == 'b' ? "(" + e.member + " ? 1ULL : 0ULL)" : "static_cast< uint64_t >(" + e.member + ")";
+                    if (e.f->bits < 64 && e.f->type != 'b') {
+                        value = "(" + value + " & " + mask(e.f->bits) + ")";
+                    }
+                    if (e.f->lsb_first) {
+                        value = "bitpacker::impl::reverse_bits< uint64_t, " + std::to_string(e.f->bits) + " >" + (value.front() == '(' ? value : "(" + value + ")");
+                    }
+                }
+                out << "            w |= " << value;
+                if (shift != 0) {
+                    out << " << " << shift << "U";
+                }
+                out << ";\n";
+            }
+            out << "            bitpacker::insert(buffer, offset + " << word.front().offset << ", " << bits << ", w);\n"
+                << "        }\n";
+        }
+        out << "    }\n\n";
+    }
+
+    void write_header(std::ostream &out, const schema &s, const std::string &schema_name)
+    {
+        const std::string qualifier = s.ns.empty() ? std::string("::") : "::" + s.ns + "::";
+        out << "// generated by bitpacker_gen from " << schema_name << ", do not edit\n"
+            << "#pragma once\n\n"
+            << "#include <bitpacker/core.hpp>\n"
+            << "#include <array>\n"
+            << "#include <cstdint>\n\n";
+        if (!s.ns.empty()) {
+            out << "namespace " << s.ns << " {\n\n";
+        }
+
+        for (const auto &m : s.messages) {
+            out << "    /// format \"" << format_string(m) << "\"\n"
+                << "    struct " << m.name << " {\n";
+            for (const auto &f : m.fields) {
+                if (f.name != "_") {
+                    out << "        " << member_type(f) << " " << f.name << ";\n";
+                }
+            }
+            out << "\n        /// the number of bits in a packed `" << m.name << "`\n"
+                << "        static constexpr bitpacker::size_type packed_bits = " << m.bits << ";\n"
+                << "    };\n\n";
+            write_pack(out, m);
+            write_unpack(out, m);
+        }
+
+        if (!s.ns.empty()) {
+            out << "}  // namespace " << s.ns << "\n\n";
+        }
+
+        out << "namespace bitpacker {\n\n";
+        for (const auto &m : s.messages) {
+            const auto type = qualifier + m.name;
+            out << "    template <>\n"
+                << "    constexpr " << type << " get< " << type << " >(span< const byte_type > buffer, size_type offset) noexcept\n"
+                << "    {\n"
+                << "        " << type << " v{};\n"
+                << "        " << qualifier << "unpack_from(buffer, offset, v);\n"
+                << "        return v;\n"
+                << "    }\n\n"
+                << "    template <>\n"
+                << "    constexpr void store< " << type << " >(span< byte_type > buffer, size_type offset, " << type << " value) noexcept\n"
+                << "    {\n"
+                << "        " << qualifier << "pack_into(buffer, offset, value);\n"
+                << "    }\n\n";
+        }
+        out << "}  // namespace bitpacker\n";
+    }
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc != 3) {
+        std::cerr << "usage: bitpacker_gen <schema file> <output header>\n";
+        return 2;
+    }
+
+    std::ifstream in(argv[1]);
+    if (!in) {
+        std::cerr << "bitpacker_gen: can not open " << argv[1] << "\n";
+        return 1;
+    }
+    schema s;
+    if (!parse_schema(in, argv[1], s)) {
+        return 1;
+    }
+
+    std::ostringstream header;
+    write_header(header, s, std::string(argv[1]).substr(std::string(argv[1]).find_last_of("/\\") + 1));
+    std::ofstream out(argv[2]);
+    if (!(out << header.str())) {
+        std::cerr << "bitpacker_gen: can not write " << argv[2] << "\n";
+        return 1;
+    }
+    return 0;
+}